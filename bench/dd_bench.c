@@ -0,0 +1,169 @@
+/* Double-double evaluation: accuracy where double has none, and its cost.
+ *
+ * The first table checks each double-double function against values worked
+ * out to 60 digits offline, and gives the relative error.
+ *
+ * The second evaluates (x-1)^7 written out as x^7 - 7x^6 + ... - 1 just
+ * right of its root, where the terms cancel: double, long double and
+ * expr_eval_dd() against the exact value.
+ *
+ * The third looks for the root x = 10 of the degree-14 polynomial with
+ * roots 1..14, expanded (all coefficients are exact in double). Double
+ * bisection is stopped short by rounding noise in the sign of f. The
+ * double-double bisection goes on to ~1e-28; Newton and the secant method,
+ * stopping at |f| <= 1e-12 with f'(10) ~ 9e6, get within ~1e-19.
+ *
+ * The last times expr_eval_dd() against expr_eval() over the corpus.
+ * Exits non-zero if any function or root is off by more than expected.
+ *
+ * Usage: ./dd_bench [corpus]
+ */
+#include <time.h>
+#include "../parser/symbolic.h"
+#include "../parser/ddouble.h"
+#include "../closed_methods/bisection.h"
+#include "../closed_methods/bisection_dd.h"
+#include "../open_methods/newton_raphton_dd.h"
+#include "../open_methods/secant_dd.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// |a - b| / |b| to double-double precision
+static double rel_err(DDouble a, DDouble b) {
+    return fabs(dd_to_double(dd_sub(a, b))) / fabs(b.hi);
+}
+
+typedef struct { const char *fn; double x, b, hi, lo; } Ref;
+
+static const Ref refs[] = {
+    { "sin", 0.5, 0,  4.79425538604203005e-01, -5.10396986055601290e-18 },
+    { "cos", 0.5, 0,  8.77582561890372759e-01, -4.26231498642799968e-17 },
+    { "tan", 0.5, 0,  5.46302489843790484e-01,  2.90965762168371759e-17 },
+    { "sin", 1.0, 0,  8.41470984807896505e-01,  1.77684509293553611e-18 },
+    { "cos", 1.0, 0,  5.40302305868139765e-01, -4.76095461260441722e-17 },
+    { "tan", 1.0, 0,  1.55740772465490229e+00, -6.18646417603759204e-17 },
+    { "sin", 3.0, 0,  1.41120008059867214e-01,  8.57726978701750168e-18 },
+    { "cos", 3.0, 0, -9.89992496600445415e-01, -4.20602615660997344e-17 },
+    { "tan", 3.0, 0, -1.42546543074277804e-01, -1.38703490678778432e-18 },
+    { "sin", 10.0, 0, -5.44021110889369774e-01, -3.89498986682235567e-17 },
+    { "cos", 10.0, 0, -8.39071529076452438e-01, -1.41471199889534177e-17 },
+    { "tan", 10.0, 0,  6.48360827459086630e-01,  4.07615160389350079e-17 },
+    { "sin", 100.0, 0, -5.06365641109758791e-01, -3.05094705379211491e-18 },
+    { "cos", 100.0, 0,  8.62318872287683891e-01,  4.33480985813650085e-17 },
+    { "tan", 100.0, 0, -5.87213915156929112e-01,  3.48828478392662520e-17 },
+    { "sin", 12345.0, 0, -9.93771636455681118e-01, -5.02920397522385997e-17 },
+    { "cos", 12345.0, 0,  1.11435786784127230e-01, -4.29438695133401158e-18 },
+    { "tan", 12345.0, 0, -8.91788594251871736e+00,  7.80751800701129403e-16 },
+    { "exp", 0.5, 0,  1.64872127070012819e+00, -4.73156847943583322e-17 },
+    { "exp", 1.0, 0,  2.71828182845904509e+00,  1.44564689172925016e-16 },
+    { "exp", -3.0, 0, 4.97870683678639445e-02, -1.48313896913943654e-18 },
+    { "exp", 10.0, 0, 2.20264657948067179e+04, -1.37801347005173720e-12 },
+    { "exp", 100.0, 0, 2.68811714181613561e+43, -1.61012714492016267e+27 },
+    { "exp", -700.0, 0, 9.85967654375977077e-305, 8.49792910846944056e-322 },
+    { "log", 0.5, 0, -6.93147180559945286e-01, -2.31904681384629956e-17 },
+    { "log", 2.0, 0,  6.93147180559945286e-01,  2.31904681384629956e-17 },
+    { "log", 3.0, 0,  1.09861228866810978e+00, -9.07129723500152996e-17 },
+    { "log", 10.0, 0, 2.30258509299404590e+00, -2.17075622338224935e-16 },
+    { "log", 1e-200, 0, -4.60517018598809159e+02, 2.20809426572410660e-14 },
+    { "log", 1e300, 0, 6.90775527898213682e+02,  2.37476600288002434e-14 },
+    { "sqrt", 2.0, 0, 1.41421356237309515e+00, -9.66729331345291345e-17 },
+    { "sqrt", 3.0, 0, 1.73205080756887719e+00,  1.00350842218069028e-16 },
+    { "sqrt", 10.0, 0, 3.16227766016837952e+00, -1.90788169707166030e-16 },
+    { "sqrt", 1e-300, 0, 1.00000000000000001e-150, 6.23418768543141537e-168 },
+    { "pow", 2.0, 0.5, 1.41421356237309515e+00, -9.66729331345291345e-17 },
+    { "pow", 3.0, 1.5, 5.19615242270663202e+00, -1.43036683195855544e-16 },
+    { "pow", 10.0, -2.25, 5.62341325190349097e-03, -1.67179119240777597e-19 },
+    { "pow", 1.5, 40, 1.10573323209400121e+07,  3.00133251585066319e-11 },
+};
+
+static DDouble apply(const char *fn, DDouble x, DDouble b) {
+    if (!strcmp(fn, "sin")) return dd_sin(x);
+    if (!strcmp(fn, "cos")) return dd_cos(x);
+    if (!strcmp(fn, "tan")) return dd_tan(x);
+    if (!strcmp(fn, "exp")) return dd_exp(x);
+    if (!strcmp(fn, "log")) return dd_log(x);
+    if (!strcmp(fn, "sqrt")) return dd_sqrt(x);
+    return dd_pow(x, b);
+}
+
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "bench/corpus.txt";
+    int bad = 0;
+
+    double worst = 0;
+    printf("%-5s %-18s %10s\n", "fn", "argument", "rel err");
+    for (size_t i = 0; i < sizeof refs / sizeof *refs; i++) {
+        const Ref *r = &refs[i];
+        double err = rel_err(apply(r->fn, dd_from(r->x), dd_from(r->b)), (DDouble){ r->hi, r->lo });
+        char arg[32];
+        snprintf(arg, sizeof arg, r->b ? "%g, %g" : "%g", r->x, r->b);
+        printf("%-5s %-18s %10.2e\n", r->fn, arg, err);
+        if (!(err <= worst)) worst = err;
+    }
+    printf("worst %.2e\n", worst);
+    bad += !(worst <= 1e-30);
+
+    const Expr *p7 = parse_function("x^7 - 7*x^6 + 21*x^5 - 35*x^4 + 35*x^3 - 21*x^2 + 7*x - 1");
+    printf("\n%-10s %12s %12s %12s %12s\n", "x", "(x-1)^7", "double err", "ldouble err", "dd err");
+    const double near[] = { 1.1, 1.03, 1.01, 1.003, 1.001 };
+    for (size_t i = 0; i < sizeof near / sizeof *near; i++) {
+        double x = near[i];
+        DDouble exact = dd_pow(dd_from(x - 1), dd_from(7));      // x - 1 is exact
+        double ed = rel_err(dd_from(expr_eval(p7, x)), exact);
+        double el = rel_err(dd_from((double)expr_evall(p7, x)), exact);
+        double edd = rel_err(expr_eval_dd(p7, dd_from(x)), exact);
+        printf("%-10g %12.3e %12.2e %12.2e %12.2e\n", x, exact.hi, ed, el, edd);
+        bad += !(edd <= 1e-8);
+    }
+    expr_free(p7);
+
+    // (x-1)(x-2)...(x-14), expanded with exact integer coefficients
+    long long c[15] = { 1 };
+    for (int r = 1; r <= 14; r++)
+        for (int i = r; i >= 0; i--) c[i] = (i ? c[i - 1] : 0) - r * c[i];
+    char text[1024];
+    int len = 0;
+    for (int i = 14; i >= 0; i--) len += snprintf(text + len, sizeof text - len, "%+lld*x^%d", c[i], i);
+    const Expr *w = parse_function(text), *dw = expr_derive(w);
+    double (*wf)(double) = expr_bind(w);
+    DDouble ten = dd_from(10), lo = dd_from(9.7), hi = dd_from(10.4);
+    double xb = bisection_meth(9.7, 10.4, 1e-12, wf);
+    DDouble xbd = bisection_meth_dd(lo, hi, dd_from(1e-28), w);
+    DDouble xn = newton_raphton_dd(dd_from(10.2), dd_from(1e-12), w, dw);
+    DDouble xs = secant_dd(dd_from(10.2), dd_from(1e-12), w);
+    printf("\nroot 10 of prod(x - k, k = 1..14), expanded:\n");
+    printf("  bisection (double)     |x - 10| = %.2e\n", fabs(xb - 10));
+    printf("  bisection_meth_dd      |x - 10| = %.2e\n", fabs(dd_sub(xbd, ten).hi));
+    printf("  newton_raphton_dd      |x - 10| = %.2e\n", fabs(dd_sub(xn, ten).hi));
+    printf("  secant_dd              |x - 10| = %.2e\n", fabs(dd_sub(xs, ten).hi));
+    bad += !(fabs(dd_sub(xbd, ten).hi) < 1e-25) + !(fabs(dd_sub(xn, ten).hi) < 1e-18) + !(fabs(dd_sub(xs, ten).hi) < 1e-18);
+    expr_unbind(w);
+    expr_free(dw);
+    expr_free(w);
+
+    FILE *in = fopen(path, "r");
+    if (!in) { fprintf(stderr, "cannot open %s\n", path); return 1; }
+    enum { NPTS = 20000 };
+    char line[512];
+    printf("\n%-56s %12s %12s %8s\n", "expression", "double ns", "dd ns", "ratio");
+    while (fgets(line, sizeof line, in)) {
+        line[strcspn(line, "#\n")] = 0;
+        if (strspn(line, " \t") == strlen(line)) continue;
+        const Expr *e = parse_function(line);
+        volatile double sink = 0;
+        double t0 = now();
+        for (int i = 0; i < NPTS; i++) sink += expr_eval(e, 0.5 + 2.5 * i / NPTS);
+        double td = (now() - t0) / NPTS;
+        t0 = now();
+        for (int i = 0; i < NPTS; i++) sink += expr_eval_dd(e, dd_from(0.5 + 2.5 * i / NPTS)).hi;
+        double tdd = (now() - t0) / NPTS;
+        printf("%-56s %12.1f %12.1f %7.1fx\n", line, td * 1e9, tdd * 1e9, tdd / td);
+        expr_free(e);
+    }
+    fclose(in);
+    return bad != 0;
+}
@@ -0,0 +1,78 @@
+/* Derivatives at a point: central differences against the complex step.
+ *
+ * For each expression in bench/corpus.txt, f' is taken over a grid on
+ * [0.5, 3] by central_diff_derivative() at two step sizes, by
+ * complex_step_derivative() with h = 1e-100 and by dual numbers. The
+ * columns give the largest relative error of each against the symbolic
+ * derivative evaluated in long double, then the cost per derivative.
+ * Exits non-zero if the complex step is ever off by more than 1e-12.
+ *
+ * Usage: ./deriv_bench [corpus]
+ */
+#include <time.h>
+#include "../parser/symbolic.h"
+#include "../parser/dual.h"
+#include "../numerical_differentiation/num_deriv.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void track(double *worst, double got, long double ref) {
+    long double scale = fabsl(ref) > 1 ? fabsl(ref) : 1;
+    double err = (double)(fabsl(got - ref) / scale);
+    if (!(err <= *worst)) *worst = err;         // NaN sticks
+}
+
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "bench/corpus.txt";
+    FILE *in = fopen(path, "r");
+    if (!in) { fprintf(stderr, "cannot open %s\n", path); return 1; }
+
+    enum { NPTS = 2001 };
+    char line[512];
+    int bad = 0;
+    double t_central = 0, t_complex = 0, t_dual = 0;
+    long calls = 0;
+    printf("%-56s %11s %11s %11s %11s\n", "expression", "central e-5", "central e-8", "complex", "dual");
+    while (fgets(line, sizeof line, in)) {
+        line[strcspn(line, "#\n")] = 0;
+        if (strspn(line, " \t") == strlen(line)) continue;
+        const Expr *e = parse_function(line), *d = expr_derive(e);
+        double (*f)(double) = expr_bind(e);
+        double c5 = 0, c8 = 0, cs = 0, du = 0;
+        volatile double sink = 0;
+
+        for (int i = 0; i < NPTS; i++) {
+            double x = 0.5 + 2.5 * i / (NPTS - 1), v, dv;
+            long double ref = expr_evall(d, x);
+            track(&c5, central_diff_derivative(x, 1e-5, f), ref);
+            track(&c8, central_diff_derivative(x, 1e-8, f), ref);
+            track(&cs, complex_step_derivative(e, x, 1e-100), ref);
+            expr_eval_dual(e, x, &v, &dv);
+            track(&du, dv, ref);
+        }
+
+        double t0 = now();
+        for (int i = 0; i < NPTS; i++) sink += central_diff_derivative(0.5 + 2.5 * i / (NPTS - 1), 1e-5, f);
+        t_central += now() - t0;
+        t0 = now();
+        for (int i = 0; i < NPTS; i++) sink += complex_step_derivative(e, 0.5 + 2.5 * i / (NPTS - 1), 1e-100);
+        t_complex += now() - t0;
+        t0 = now();
+        for (int i = 0; i < NPTS; i++) { double v, dv; expr_eval_dual(e, 0.5 + 2.5 * i / (NPTS - 1), &v, &dv); sink += dv; }
+        t_dual += now() - t0;
+        calls += NPTS;
+
+        printf("%-56s %11.2e %11.2e %11.2e %11.2e\n", line, c5, c8, cs, du);
+        bad += !(cs <= 1e-12);
+        expr_free(d);
+        expr_free(e);
+    }
+    fclose(in);
+    printf("\nns per derivative: central %.1f, complex step %.1f, dual %.1f\n",
+           t_central / calls * 1e9, t_complex / calls * 1e9, t_dual / calls * 1e9);
+    return bad != 0;
+}
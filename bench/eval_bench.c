@@ -0,0 +1,213 @@
+/* Microbenchmark for the RPN evaluator.
+ *
+ * "before" replays the old evaluator, which malloc'd and freed an operand
+ * stack on every call; "after" is expr_eval(), whose stack depth is fixed at
+ * compile time and lives on the C stack. "batch" feeds the same points
+ * through expr_eval_batch() 1024 at a time.
+ *
+ * The second table runs the batch evaluator in each precision and gives
+ * the largest relative error of float and double against long double.
+ *
+ * The third table times parse_function() on text it has seen before, which
+ * the expression cache answers, against compiling from scratch every time.
+ * The sweep line evaluates a*sin(x) - b*x for many (a, b) pairs, once by
+ * printing each pair into the text and parsing it, once by rebinding the
+ * parameters of "$a*sin(x) - $b*x", and checks both agree to the bit and
+ * that out-of-range parameter indices are refused.
+ * The last line compares compiling a library of 1024 expressions with
+ * mapping it from a bytecode file written by expr_save(), and checks the
+ * loaded programs give bit-identical results. Copies of the file with a
+ * stack depth or slot count no program could need must be rejected.
+ *
+ * Usage: ./eval_bench [evaluations]
+ */
+#include <time.h>
+#include <stddef.h>
+#include "../parser/parser.h"
+#include "../parser/bytecode.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double eval_malloc(const Expr *e, double x){
+    double *stk = malloc(e->len * sizeof *stk);
+    double out = eval_rpn(e, stk, &x);
+    free(stk);
+    return out;
+}
+
+static const char *exprs[] = {
+    "x^2-2",
+    "x*x*x - 2*x + 1",
+    "sin(x)*cos(x) + sqrt(x)",
+    "(x+1)*(x-1)/(x^2+1) - 3*x^3 + 2*x^2 - x + 7",
+};
+
+int main(int argc, char **argv){
+    long n = argc > 1 ? atol(argv[1]) : 5000000;
+    printf("%-48s %14s %14s %8s %14s\n", "expression", "before eval/s", "after eval/s", "speedup", "batch eval/s");
+    for (size_t k = 0; k < sizeof exprs / sizeof *exprs; k++) {
+        const Expr *e = parse_function(exprs[k]);
+        volatile double sink = 0;
+
+        double t0 = now();
+        for (long i = 0; i < n; i++) sink += eval_malloc(e, i * 1e-6);
+        double before = n / (now() - t0);
+
+        t0 = now();
+        for (long i = 0; i < n; i++) sink += expr_eval(e, i * 1e-6);
+        double after = n / (now() - t0);
+
+        double xs[1024], ys[1024];
+        t0 = now();
+        for (long i = 0; i < n; i += 1024) {
+            for (int j = 0; j < 1024; j++) xs[j] = (i + j) * 1e-6;
+            expr_eval_batch(e, xs, ys, 1024);
+            sink += ys[0];
+        }
+        double batch = n / (now() - t0);
+
+        printf("%-48s %14.3e %14.3e %7.2fx %14.3e\n", exprs[k], before, after, after / before, batch);
+        expr_free(e);
+    }
+
+    printf("\n%-48s %14s %14s %14s %12s %12s\n", "expression", "float eval/s", "double eval/s",
+           "ldouble eval/s", "float err", "double err");
+    for (size_t k = 0; k < sizeof exprs / sizeof *exprs; k++) {
+        const Expr *e = parse_function(exprs[k]);
+        float xf[1024], yf[1024];
+        double xd[1024], yd[1024];
+        long double xl[1024], yl[1024];
+        for (int j = 0; j < 1024; j++) xl[j] = xd[j] = xf[j] = 0.5f + j / 256.0f;   // exact in every precision
+        volatile long double sink = 0;
+
+        double t0 = now();
+        for (long i = 0; i < n; i += 1024) { expr_eval_batchf(e, xf, yf, 1024); sink += yf[0]; }
+        double tf = n / (now() - t0);
+        t0 = now();
+        for (long i = 0; i < n; i += 1024) { expr_eval_batch(e, xd, yd, 1024); sink += yd[0]; }
+        double td = n / (now() - t0);
+        t0 = now();
+        for (long i = 0; i < n; i += 1024) { expr_eval_batchl(e, xl, yl, 1024); sink += yl[0]; }
+        double tl = n / (now() - t0);
+
+        long double ef = 0, ed = 0;
+        for (int j = 0; j < 1024; j++) {
+            long double scale = fabsl(yl[j]) > 1 ? fabsl(yl[j]) : 1;
+            ef = fmaxl(ef, fabsl(yf[j] - yl[j]) / scale);
+            ed = fmaxl(ed, fabsl(yd[j] - yl[j]) / scale);
+        }
+        printf("%-48s %14.3e %14.3e %14.3e %12.3Le %12.3Le\n", exprs[k], tf, td, tl, ef, ed);
+        expr_free(e);
+    }
+
+    long np = n / 50;
+    printf("\n%-48s %14s %14s %8s\n", "expression", "compile/s", "cached/s", "speedup");
+    for (size_t k = 0; k < sizeof exprs / sizeof *exprs; k++) {
+        double t0 = now();
+        for (long i = 0; i < np; i++) expr_free(compile_function(exprs[k], (const char *const[]){ "x" }, 1));
+        double compile = np / (now() - t0);
+
+        t0 = now();
+        for (long i = 0; i < np; i++) expr_free(parse_function(exprs[k]));
+        double cached = np / (now() - t0);
+        printf("%-48s %14.3e %14.3e %7.2fx\n", exprs[k], compile, cached, cached / compile);
+    }
+    ExprCacheStats cs = expr_cache_stats();
+    printf("cache: %zu hits, %zu misses, %d entries\n", cs.hits, cs.misses, cs.entries);
+    expr_cache_clear();
+
+    enum { NSWEEP = 20000, NPTS = 16 };
+    const Expr *pf = parse_function("$a*sin(x) - $b*x");
+    int pa = expr_param_index(pf, "a"), pb = expr_param_index(pf, "b"), sweep_bad = 0;
+    double sum_text = 0, sum_param = 0;
+    double t0 = now();
+    for (int k = 0; k < NSWEEP; k++) {
+        char txt[96];
+        snprintf(txt, sizeof txt, "%.17g*sin(x) - %.17g*x", 1 + k * 1e-4, 2 - k * 1e-4);
+        const Expr *e = parse_function(txt);
+        for (int j = 0; j < NPTS; j++) sum_text += expr_eval(e, j * 0.25);
+        expr_free(e);
+    }
+    double by_text = now() - t0;
+    t0 = now();
+    for (int k = 0; k < NSWEEP; k++) {
+        expr_set_param(pf, pa, 1 + k * 1e-4);
+        expr_set_param(pf, pb, 2 - k * 1e-4);
+        for (int j = 0; j < NPTS; j++) sum_param += expr_eval(pf, j * 0.25);
+    }
+    double by_param = now() - t0;
+    sweep_bad = memcmp(&sum_text, &sum_param, sizeof sum_text) != 0;
+    printf("\nsweep of %d (a, b) pairs x %d points: re-parse %.3f ms, rebind $params %.3f ms (%.1fx), %d mismatches\n",
+           NSWEEP, NPTS, by_text * 1e3, by_param * 1e3, by_text / by_param, sweep_bad);
+    // a misspelt name, and an expression without parameters, must be refused rather than written past
+    const Expr *plain = parse_function("sin(x)");
+    sweep_bad += expr_set_param(pf, expr_param_index(pf, "typo"), 1) != -1 || !isnan(expr_get_param(pf, 2))
+               || expr_set_param(plain, 0, 1) != -1 || expr_get_param(pf, pa) != 1 + (NSWEEP - 1) * 1e-4;
+    expr_free(plain);
+    expr_free(pf);
+    expr_cache_clear();
+
+    // a model library: the expressions above, each with many different offsets
+    enum { NLIB = 1024, REPS = 20 };
+    static char text[NLIB][96];
+    const char *names[NLIB];
+    const Expr *lib[NLIB];
+    for (int k = 0; k < NLIB; k++) {
+        snprintf(text[k], sizeof text[k], "%s + %d", exprs[k % (sizeof exprs / sizeof *exprs)], k);
+        names[k] = text[k];
+        lib[k] = compile_function(text[k], (const char *const[]){ "x" }, 1);
+    }
+    const char *path = "bench/eval_bench.rpnb";
+    if (expr_save(path, lib, names, NLIB) != 0) return 1;
+
+    int bad = sweep_bad;
+    t0 = now();
+    for (int r = 0; r < REPS; r++)
+        for (int k = 0; k < NLIB; k++) expr_free(compile_function(text[k], (const char *const[]){ "x" }, 1));
+    double compile = (now() - t0) / REPS;
+
+    t0 = now();
+    for (int r = 0; r < REPS; r++) {
+        ExprLib *L = expr_lib_open(path);
+        for (int k = 0; k < NLIB; k++) {
+            double a = expr_eval(expr_lib_find(L, names[k]), 0.75), b = expr_eval(lib[k], 0.75);
+            bad += memcmp(&a, &b, sizeof a) != 0;
+        }
+        expr_lib_close(L);
+    }
+    double load = (now() - t0) / REPS;
+    printf("\nstartup for %d expressions: compile %.3f ms, mmap bytecode %.3f ms (%.1fx), %d mismatches\n",
+           NLIB, compile * 1e3, load * 1e3, compile / load, bad);
+
+    // depth and nslots size the evaluator's stack array, so lies about them must not load
+    const struct { size_t at; uint32_t v; } lies[] = {
+        { offsetof(ExprFileEntry, depth), 0x7fffffff }, { offsetof(ExprFileEntry, depth), 0 },
+        { offsetof(ExprFileEntry, nslots), 0x7fffffff },
+    };
+    int loaded = 0;
+    for (size_t k = 0; k < sizeof lies / sizeof *lies; k++) {
+        FILE *f = fopen(path, "r+b");
+        uint32_t was;
+        fseek(f, sizeof(ExprFileHeader) + lies[k].at, SEEK_SET);
+        fread(&was, sizeof was, 1, f);
+        fseek(f, sizeof(ExprFileHeader) + lies[k].at, SEEK_SET);
+        fwrite(&lies[k].v, sizeof lies[k].v, 1, f);
+        fflush(f);
+        ExprLib *L = expr_lib_open(path);
+        loaded += L != NULL;
+        expr_lib_close(L);
+        fseek(f, sizeof(ExprFileHeader) + lies[k].at, SEEK_SET);
+        fwrite(&was, sizeof was, 1, f);
+        fclose(f);
+    }
+    printf("corrupt depth/nslots: %s\n", loaded ? "LOADED" : "rejected");
+    bad += loaded;
+
+    for (int k = 0; k < NLIB; k++) expr_free(lib[k]);
+    remove(path);
+    return bad != 0;
+}
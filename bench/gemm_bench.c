@@ -0,0 +1,127 @@
+/* GFLOP/s of multiply() for n x n matrices, n = 16 to 4096.
+ *
+ * "naive" is the triple loop multiply() used before gemm.h, run up to
+ * n = 1024 (at 4096 it would take minutes). "scalar" and "avx2" are the
+ * blocked gemm() with each micro-kernel forced through gemm_isa. Each
+ * size is repeated until it has run for at least 0.2 s.
+ *
+ * Before that, gemm() is checked against the naive product on awkward
+ * shapes (edges of every width, k past one KC block, n past one NC block)
+ * and on views: a sub-block and a transposed view as operands. Exits
+ * non-zero if any result is off by more than rounding.
+ *
+ * Usage: ./gemm_bench [max n]
+ */
+#include <time.h>
+#include <stdint.h>
+#include "../linear_equations/matrix.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+static Matrix random_matrix(unsigned rows, unsigned cols) {
+    Matrix m = initMatrix(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+        for (unsigned j = 0; j < cols; j++)
+            MAT(m, i, j) = uniform() * 2 - 1;
+    return m;
+}
+
+// multiply() as it was: one dot product per element of the result
+static Matrix naive_multiply(Matrix mat1, Matrix mat2) {
+    Matrix ret = initMatrix(mat1.rows, mat2.cols);
+    for (size_t y = 0; y < ret.rows; y++)
+        for (size_t x = 0; x < ret.cols; x++) {
+            double res = 0.0;
+            for (size_t i = 0; i < mat1.cols; i++)
+                res += MAT(mat1, y, i) * MAT(mat2, i, x);
+            MAT(ret, y, x) = res;
+        }
+    return ret;
+}
+
+// largest |a - b| over the largest error rounding can explain: k ulps of k (entries are in [-1, 1])
+static double error_ratio(Matrix a, Matrix b, unsigned k) {
+    double worst = 0;
+    for (unsigned i = 0; i < a.rows; i++)
+        for (unsigned j = 0; j < a.cols; j++)
+            worst = fmax(worst, fabs(MAT(a, i, j) - MAT(b, i, j)));
+    return worst / ((double)k * k * 0x1p-52);
+}
+
+static const char *isa_name[] = { "auto", "scalar", "avx2" };
+
+int main(int argc, char **argv){
+    unsigned max_n = argc > 1 ? (unsigned)atoi(argv[1]) : 4096;
+    bool has_avx2 = false;
+#ifdef GEMM_X86
+    has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    int bad = 0;
+
+    const unsigned shapes[][3] = {
+        { 1, 1, 1 }, { 5, 7, 3 }, { 6, 8, 1 }, { 7, 9, 300 }, { 13, 17, 257 }, { 73, 33, 600 },
+        { 100, 2050, 20 }, { 3, 4100, 2 }, { 150, 150, 150 }, { 1, 500, 500 }, { 500, 1, 500 },
+    };
+    printf("%-16s %-8s %10s\n", "m x n x k", "kernel", "err/bound");
+    for (int isa = GEMM_SCALAR; isa <= (has_avx2 ? GEMM_AVX2 : GEMM_SCALAR); isa++) {
+        gemm_isa = isa;
+        for (size_t s = 0; s < sizeof shapes / sizeof *shapes; s++) {
+            unsigned m = shapes[s][0], n = shapes[s][1], k = shapes[s][2];
+            Matrix a = random_matrix(m, k), b = random_matrix(k, n);
+            Matrix want = naive_multiply(a, b), got = multiply(a, b);
+            double r = error_ratio(got, want, k);
+            char shape[32];
+            snprintf(shape, sizeof shape, "%ux%ux%u", m, n, k);
+            printf("%-16s %-8s %10.3f\n", shape, isa_name[isa], r);
+            bad += !(r <= 1);
+            freeMatrix(a); freeMatrix(b); freeMatrix(want); freeMatrix(got);
+        }
+
+        // A^T * B[block]: a transposed view and a sub-block go in as they are
+        Matrix big = random_matrix(90, 120), a = random_matrix(70, 45);
+        Matrix at = transposeView(a), blk = subBlock(big, 11, 23, 70, 61);
+        Matrix a_copy = copyMatrix(at), blk_copy = copyMatrix(blk);
+        Matrix want = naive_multiply(a_copy, blk_copy), got = multiply(at, blk);
+        double r = error_ratio(got, want, 70);
+        printf("%-16s %-8s %10.3f\n", "views", isa_name[isa], r);
+        bad += !(r <= 1);
+        freeMatrix(big); freeMatrix(a); freeMatrix(a_copy); freeMatrix(blk_copy); freeMatrix(want); freeMatrix(got);
+    }
+    gemm_isa = GEMM_AUTO;
+
+    printf("\nGFLOP/s\n%6s %12s %12s %12s\n", "n", "naive", "scalar", "avx2");
+    for (unsigned n = 16; n <= max_n; n *= 2) {
+        Matrix a = random_matrix(n, n), b = random_matrix(n, n);
+        double flops = 2.0 * n * n * n, rate[3] = { 0, 0, 0 };
+        for (int col = 0; col < 3; col++) {
+            if ((col == 0 && n > 1024) || (col == 2 && !has_avx2)) continue;
+            gemm_isa = col == 1 ? GEMM_SCALAR : GEMM_AVX2;
+            int reps = 0;
+            double t0 = now(), t;
+            do {
+                Matrix c = col == 0 ? naive_multiply(a, b) : multiply(a, b);
+                freeMatrix(c);
+                reps++;
+            } while ((t = now() - t0) < 0.2);
+            rate[col] = flops * reps / t * 1e-9;
+        }
+        printf("%6u", n);
+        for (int col = 0; col < 3; col++)
+            rate[col] ? printf(" %12.2f", rate[col]) : printf(" %12s", "-");
+        printf("\n");
+        freeMatrix(a); freeMatrix(b);
+    }
+    gemm_isa = GEMM_AUTO;
+    return bad != 0;
+}
@@ -0,0 +1,60 @@
+/* Root bracketing: blind stepping against interval branch and prune.
+ *
+ * "scan" walks [a, b] in steps of dx the way graph_meth() does and counts
+ * the sign changes it sees; "interval" is interval_roots() with eps = dx.
+ * Every root the scan brackets must fall inside a box the interval search
+ * returned, since the search only discards what provably has no root; the
+ * program exits non-zero if one does not.
+ *
+ * Usage: ./interval_bench [dx]
+ */
+#include "../closed_methods/interval_roots.h"
+#include "../closed_methods/bisection.h"
+
+static const struct { const char *f; double a, b; } cases[] = {
+    { "x^3 - 2*x - 5",          -1000, 1000 },
+    { "sin(x) - 0.5",            -100,  100 },
+    { "(x-1)*(x-2)*(x-3)",       -1000, 1000 },
+    { "exp(x/10) - x^2",         -100,  100 },
+    { "log(x^2+1) - 2",          -1000, 1000 },
+    { "cos(x)^2 - sin(x)/2",     -50,   50 },
+    { "sqrt(x) - 1/(x+1)",       0,     1000 },
+};
+
+int main(int argc, char **argv){
+    double dx = argc > 1 ? atof(argv[1]) : 1e-4;
+    RootBox box[512];
+    int bad = 0;
+
+    printf("%-24s %16s %8s %14s %8s %8s %10s\n", "f(x)", "range", "roots", "scan evals", "boxes", "unique", "interval");
+    for (size_t k = 0; k < sizeof cases / sizeof *cases; k++) {
+        const Expr *e = parse_function(cases[k].f);
+        double a = cases[k].a, b = cases[k].b;
+
+        long scan = 1;
+        int roots = 0;
+        double prev = expr_eval(e, a);
+        double r[512];
+        for (long i = 1; a + i * dx <= b; i++, scan++) {
+            double x = a + i * dx, y = expr_eval(e, x);
+            if ((y == 0 || prev * y < 0) && roots < 512) r[roots++] = bisection_meth(x - dx, x, 1e-12, expr_bind(e));
+            prev = y;
+        }
+
+        long evals;
+        int n = interval_roots(e, a, b, dx, box, 512, &evals);
+        int unique = 0;
+        for (int i = 0; i < n; i++) unique += box[i].unique;
+        for (int i = 0; i < roots; i++) {
+            int j = 0;
+            while (j < n && !(box[j].lo <= r[i] + 1e-9 && r[i] - 1e-9 <= box[j].hi)) j++;
+            if (j == n) { printf("  missed root %.12f\n", r[i]); bad++; }
+        }
+
+        char range[32];
+        snprintf(range, sizeof range, "[%g, %g]", a, b);
+        printf("%-24s %16s %8d %14ld %8d %8d %10ld\n", cases[k].f, range, roots, scan, n, unique, evals);
+        expr_free(e);
+    }
+    return bad != 0;
+}
@@ -0,0 +1,65 @@
+/* Checks that expr_jit() code is bit-identical to the interpreter and
+ * reports evaluations per second for both. Exits non-zero on a mismatch.
+ *
+ * Usage: ./jit_bench [evaluations]
+ */
+#include <time.h>
+#include "../parser/parser.h"
+#include "../parser/jit.h"
+#include "../closed_methods/bisection.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *exprs[] = {
+    "x^2-2",
+    "x*x*x - 2*x + 1",
+    "sin(x)*cos(x) + sqrt(x)",
+    "exp(-0.5*x^2) / sqrt(2*3.141592653589793)",
+    "(x+1)*(x-1)/(x^2+1) - 3*x^3 + 2*x^2 - x + 7",
+    "log(x^2+1) - tan(x/3) + 2^x",
+    "((x-1)^7 + (x+2)^-3) / (x^2.5 + e)",
+};
+
+int main(int argc, char **argv){
+    long n = argc > 1 ? atol(argv[1]) : 5000000;
+    int bad = 0;
+    if (!EXPR_HAVE_JIT) { printf("JIT backend not available on this platform\n"); return 0; }
+
+    printf("%-48s %10s %14s %14s %8s\n", "expression", "mismatch", "interp eval/s", "jit eval/s", "speedup");
+    for (size_t k = 0; k < sizeof exprs / sizeof *exprs; k++) {
+        const Expr *e = parse_function(exprs[k]);
+        double (*f)(double) = expr_jit(e);
+
+        int mismatches = 0;
+        for (double x = -50; x <= 50; x += 0.0137) {
+            double a = expr_eval(e, x), b = f(x);
+            if (memcmp(&a, &b, sizeof a)) mismatches++;
+        }
+        bad += mismatches;
+
+        volatile double sink = 0;
+        double t0 = now();
+        for (long i = 0; i < n; i++) sink += expr_eval(e, i * 1e-6);
+        double interp = n / (now() - t0);
+        t0 = now();
+        for (long i = 0; i < n; i++) sink += f(i * 1e-6);
+        double jit = n / (now() - t0);
+
+        printf("%-48s %10d %14.3e %14.3e %7.2fx\n", exprs[k], mismatches, interp, jit, jit / interp);
+        expr_jit_free(f);
+        expr_free(e);
+    }
+
+    const Expr *e = parse_function("x^2-2");
+    double (*f)(double) = expr_jit(e);
+    double r1 = bisection_meth(0, 2, 1e-12, f), r2 = bisection_meth(0, 2, 1e-12, expr_bind(e));
+    printf("bisection on x^2-2: jit %.15f, interpreter %.15f\n", r1, r2);
+    bad += r1 != r2;
+    expr_jit_free(f);
+    expr_free(e);
+    return bad != 0;
+}
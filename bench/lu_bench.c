@@ -0,0 +1,177 @@
+/* LU factorisation against the cofactor expansion it replaced.
+ *
+ * For random n x n matrices (n around the LU_BLOCK boundaries included)
+ * each row gives:
+ * - |PA - LU|, |AX - B| for 3 right-hand sides, and |A inv(A) - I|, all in
+ *   units of n * eps * |A| (max norms);
+ * - for n <= 8, determinant() against the old cofactor expansion.
+ *
+ * A singular matrix must give determinant 0 and an empty inverse. The
+ * inverse must be bit-identical with 1 and 3 threads.
+ *
+ * The timing table runs determinant() and inverse(), old and new. The old
+ * ones only go as far as they finish in reasonable time: det to n = 10,
+ * inverse to n = 8. lu_factor() is also timed up to n = 2000.
+ *
+ * Exits non-zero if a residual goes over 10, or a determinant, the
+ * singular case or the thread check is off.
+ *
+ * Usage: ./lu_bench
+ */
+#include <time.h>
+#include <stdint.h>
+#include "../linear_equations/matrix.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+static Matrix random_matrix(unsigned rows, unsigned cols) {
+    Matrix m = initMatrix(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+        for (unsigned j = 0; j < cols; j++)
+            MAT(m, i, j) = uniform() * 2 - 1;
+    return m;
+}
+
+static double max_abs(Matrix m) {
+    double r = 0;
+    for (unsigned i = 0; i < m.rows; i++)
+        for (unsigned j = 0; j < m.cols; j++) r = fmax(r, fabs(MAT(m, i, j)));
+    return r;
+}
+
+/* --- The code LU replaced --- */
+
+static double old_determinant(Matrix mat) {
+    if (mat.cols == 1) return MAT(mat, 0, 0);
+    if (mat.cols == 2) return MAT(mat, 0, 0) * MAT(mat, 1, 1) - MAT(mat, 0, 1) * MAT(mat, 1, 0);
+    double res = 0.0;
+    for (unsigned j = 0; j < mat.cols; j++) {
+        Matrix sub = submat(mat, 0, j);
+        res += ipow(-1, j) * MAT(mat, 0, j) * old_determinant(sub);
+        freeMatrix(sub);
+    }
+    return res;
+}
+
+static Matrix old_inverse(Matrix mat) {
+    Matrix adj = initMatrix(mat.rows, mat.cols);
+    for (unsigned i = 0; i < mat.rows; i++)
+        for (unsigned j = 0; j < mat.cols; j++) {
+            Matrix sub = submat(mat, i, j);
+            MAT(adj, j, i) = ipow(-1, i + j) * old_determinant(sub);
+            freeMatrix(sub);
+        }
+    scalarDivide(adj, old_determinant(mat));
+    return adj;
+}
+
+int main(void){
+    int bad = 0;
+    const double eps = 0x1p-52;
+
+    printf("%6s %10s %10s %10s %12s\n", "n", "PA-LU", "AX-B", "A*inv-I", "det rel err");
+    const unsigned sizes[] = { 1, 2, 3, 5, 8, 12, 63, 64, 65, 129, 300 };
+    for (size_t s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+        unsigned n = sizes[s];
+        Matrix a = random_matrix(n, n);
+        double scale = n * eps * max_abs(a);
+        LU f = lu_factor(a);
+
+        // PA - LU, with L and U pulled out of the packed factors
+        Matrix l = initMatrix(n, n), u = initMatrix(n, n);
+        for (unsigned i = 0; i < n; i++)
+            for (unsigned j = 0; j < n; j++) {
+                if (j < i) MAT(l, i, j) = MAT(f.lu, i, j);
+                else MAT(u, i, j) = MAT(f.lu, i, j);
+                if (i == j) MAT(l, i, i) = 1;
+            }
+        Matrix prod = multiply(l, u);
+        double r_lu = 0;
+        for (unsigned i = 0; i < n; i++)
+            for (unsigned j = 0; j < n; j++) r_lu = fmax(r_lu, fabs(MAT(a, f.perm[i], j) - MAT(prod, i, j)));
+        r_lu /= scale;
+
+        Matrix b = random_matrix(n, 3), x = lu_solve(f, b), ax = multiply(a, x), d = subtract(ax, b);
+        double r_solve = max_abs(d) / (scale * max_abs(x));
+
+        Matrix inv = inverse(a), ai = multiply(a, inv);
+        for (unsigned i = 0; i < n; i++) MAT(ai, i, i) -= 1;
+        double r_inv = max_abs(ai) / (scale * max_abs(inv));
+
+        printf("%6u %10.3f %10.3f %10.3f", n, r_lu, r_solve, r_inv);
+        bad += !(r_lu <= 10) + !(r_solve <= 10) + !(r_inv <= 10);
+        if (n <= 8) {
+            double want = old_determinant(a), got = determinant(a), rel = fabs(got - want) / fabs(want);
+            printf(" %12.2e", rel);
+            bad += !(rel <= 1e-12);
+        }
+        printf("\n");
+
+        lu_free(f);
+        freeMatrix(a); freeMatrix(l); freeMatrix(u); freeMatrix(prod);
+        freeMatrix(b); freeMatrix(x); freeMatrix(ax); freeMatrix(d); freeMatrix(inv); freeMatrix(ai);
+    }
+
+    // row 1 = 2 * row 0, eliminated without rounding; and an exact determinant
+    double sing[] = { 1, 2, 3, 2, 4, 6, 1, 1, 1 }, tri[] = { 2, 0, 0, 7, -3, 0, 1, 5, 4 };
+    Matrix s = initMatrix(3, 3), t = initMatrix(3, 3);
+    setDataMatrix(s, sing);
+    setDataMatrix(t, tri);
+    Matrix si = inverse(s);
+    bool ok = determinant(s) == 0 && si.data == NULL && determinant(t) == -24 && determinant(transposeView(t)) == -24;
+    printf("singular and exact determinants: %s\n", ok ? "ok" : "FAILED");
+    bad += !ok;
+    freeMatrix(s); freeMatrix(t);
+
+    Matrix big = random_matrix(400, 400);
+    pool_set_threads(1);
+    Matrix i1 = inverse(big);
+    pool_set_threads(3);
+    Matrix i3 = inverse(big);
+    pool_set_threads(0);
+    ok = true;
+    for (unsigned i = 0; i < 400; i++) ok &= !memcmp(&MAT(i1, i, 0), &MAT(i3, i, 0), 400 * sizeof(double));
+    printf("inverse, 1 thread vs 3: %s\n", ok ? "same" : "DIFFERENT");
+    bad += !ok;
+    freeMatrix(big); freeMatrix(i1); freeMatrix(i3);
+
+    printf("\n%6s %14s %14s %14s %14s %14s\n", "n", "old det ms", "det ms", "old inv ms", "inv ms", "factor GFLOP/s");
+    const unsigned timed[] = { 4, 6, 8, 10, 12, 100, 500, 1000, 2000 };
+    for (size_t k = 0; k < sizeof timed / sizeof *timed; k++) {
+        unsigned n = timed[k];
+        Matrix a = random_matrix(n, n);
+        volatile double sink = 0;
+        double t0, od = -1, oi = -1;
+        if (n <= 10) { t0 = now(); sink += old_determinant(a); od = now() - t0; }
+        if (n <= 8) { t0 = now(); Matrix m = old_inverse(a); oi = now() - t0; freeMatrix(m); }
+        t0 = now();
+        sink += determinant(a);
+        double nd = now() - t0;
+        t0 = now();
+        Matrix m = inverse(a);
+        double ni = now() - t0;
+        freeMatrix(m);
+        int reps = 0;
+        t0 = now();
+        double tf;
+        do { LU f = lu_factor(a); lu_free(f); reps++; } while ((tf = now() - t0) < 0.2);
+        printf("%6u", n);
+        od < 0 ? printf(" %14s", "-") : printf(" %14.3f", od * 1e3);
+        printf(" %14.3f", nd * 1e3);
+        oi < 0 ? printf(" %14s", "-") : printf(" %14.3f", oi * 1e3);
+        printf(" %14.3f %14.2f\n", ni * 1e3, 2.0 / 3 * n * n * n * reps / tf * 1e-9);
+        freeMatrix(a);
+    }
+    return bad != 0;
+}
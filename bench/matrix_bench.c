@@ -0,0 +1,208 @@
+/* Matrix storage: views against copies, and the old row-pointer layout.
+ *
+ * The first part checks that views read and write the elements they should:
+ * rowRange(), subBlock() and transposeView() are compared with copies made
+ * element by element, and copyMatrix(), transpose(), submat(), determinant(),
+ * cholesky() and gauss_seidal() are run on views and on compact copies of
+ * them, which must give identical results.
+ *
+ * The second times allocating, filling and freeing an n x n matrix in this
+ * layout and in the old one (a calloc per row under a double** spine), and
+ * multiply() against the naive product on the old layout.
+ *
+ * Exits non-zero if any view check fails or the products differ by more
+ * than rounding.
+ *
+ * Usage: ./matrix_bench
+ */
+#include <time.h>
+#include <stdint.h>
+#include "../linear_equations/matrix.h"
+#include "../linear_equations/cholesky.h"
+#include "../linear_equations/gauss_seidal.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+static Matrix random_matrix(unsigned rows, unsigned cols) {
+    Matrix m = initMatrix(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+        for (unsigned j = 0; j < cols; j++)
+            MAT(m, i, j) = uniform() * 2 - 1;
+    return m;
+}
+
+static bool same_matrix(Matrix a, Matrix b) {
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (unsigned i = 0; i < a.rows; i++)
+        for (unsigned j = 0; j < a.cols; j++)
+            if (MAT(a, i, j) != MAT(b, i, j)) return false;
+    return true;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    failures += !ok;
+}
+
+/* a diagonally dominant, symmetric positive definite n x n block at (at, at)
+ * of a larger matrix; entries fall along each row, so the row sort in
+ * gauss_seidal() leaves it as it is and the iteration converges */
+static Matrix spd_block(Matrix big, unsigned at, unsigned n) {
+    Matrix a = subBlock(big, at, at, n, n);
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned j = 0; j < n; j++)
+            MAT(a, i, j) = i == j ? n + 1 : 1.0 / (1 + i + j);
+    return a;
+}
+
+/* --- The old layout, for timing --- */
+
+typedef struct { double **data; unsigned rows, cols; } RowMatrix;
+
+static RowMatrix row_init(unsigned rows, unsigned cols) {
+    RowMatrix m = { malloc(sizeof(double *) * rows), rows, cols };
+    for (unsigned i = 0; i < rows; i++) m.data[i] = calloc(cols, sizeof(double));
+    return m;
+}
+
+static void row_free(RowMatrix m) {
+    for (unsigned i = 0; i < m.rows; i++) free(m.data[i]);
+    free(m.data);
+}
+
+static RowMatrix row_multiply(RowMatrix a, RowMatrix b) {
+    RowMatrix r = row_init(a.rows, b.cols);
+    for (unsigned y = 0; y < r.rows; y++)
+        for (unsigned x = 0; x < r.cols; x++) {
+            double res = 0.0;
+            for (unsigned i = 0; i < a.cols; i++) res += a.data[y][i] * b.data[i][x];
+            r.data[y][x] = res;
+        }
+    return r;
+}
+
+int main(void){
+    Matrix big = random_matrix(40, 50);
+
+    Matrix rows = rowRange(big, 7, 20), rows_copy = initMatrix(20, 50);
+    for (unsigned i = 0; i < 20; i++)
+        for (unsigned j = 0; j < 50; j++) MAT(rows_copy, i, j) = MAT(big, i + 7, j);
+    check(same_matrix(rows, rows_copy) && rows.owner == NULL, "rowRange reads the parent rows");
+
+    Matrix blk = subBlock(big, 3, 11, 12, 9), blk_copy = initMatrix(12, 9);
+    for (unsigned i = 0; i < 12; i++)
+        for (unsigned j = 0; j < 9; j++) MAT(blk_copy, i, j) = MAT(big, i + 3, j + 11);
+    check(same_matrix(blk, blk_copy), "subBlock reads the parent block");
+
+    Matrix tv = transposeView(blk), tv_copy = initMatrix(9, 12);
+    for (unsigned i = 0; i < 9; i++)
+        for (unsigned j = 0; j < 12; j++) MAT(tv_copy, i, j) = MAT(blk, j, i);
+    check(same_matrix(tv, tv_copy), "transposeView of a subBlock");
+
+    Matrix t = transpose(blk), c = copyMatrix(tv);
+    check(same_matrix(t, tv_copy) && same_matrix(c, tv_copy) && c.owner == c.data && c.step == 1,
+          "transpose and copyMatrix of views are compact copies");
+    freeMatrix(t); freeMatrix(c);
+
+    MAT(tv, 4, 2) = 42;
+    check(MAT(big, 5, 15) == 42, "writes through a view reach the parent");
+    double outside = MAT(big, 2, 11);
+    scalarMultiply(blk, 2);
+    scalarMultiply(blk_copy, 2);
+    MAT(blk_copy, 2, 4) = 84;
+    check(same_matrix(blk, blk_copy) && MAT(big, 2, 11) == outside,
+          "scalarMultiply on a view stays inside it");
+
+    Matrix sq = subBlock(big, 20, 30, 7, 7), sq_copy = copyMatrix(transposeView(sq));
+    Matrix m1 = submat(transposeView(sq), 2, 5), m2 = submat(sq_copy, 2, 5);
+    check(same_matrix(m1, m2), "submat of a transposed view");
+    check(determinant(transposeView(sq)) == determinant(sq_copy), "determinant of a transposed view");
+    freeMatrix(m1); freeMatrix(m2); freeMatrix(sq_copy);
+
+    Matrix a = spd_block(big, 10, 8), b = subBlock(big, 30, 45, 8, 1);
+    Matrix a_copy = copyMatrix(a), b_copy = copyMatrix(b);
+    Matrix x1 = cholesky(a, b, 1e-12), x2 = cholesky(a_copy, b_copy, 1e-12);
+    check(same_matrix(x1, x2), "cholesky on views");
+    Matrix g1 = gauss_seidal(a, b, 1e-12), g2 = gauss_seidal(a_copy, b_copy, 1e-12);
+    check(same_matrix(g1, g2) && same_matrix(a, a_copy), "gauss_seidal on views, parent untouched");
+    double resid = 0;
+    for (unsigned i = 0; i < 8; i++) {
+        double r = -MAT(b, i, 0);
+        for (unsigned j = 0; j < 8; j++) r += MAT(a, i, j) * MAT(x1, j, 0);
+        resid = fmax(resid, fabs(r));
+    }
+    check(resid < 1e-12, "cholesky residual");
+    freeMatrix(x1); freeMatrix(x2); freeMatrix(g1); freeMatrix(g2); freeMatrix(a_copy); freeMatrix(b_copy);
+
+    bool aligned = true;
+    for (unsigned n = 1; n < 40; n++) {
+        Matrix al = initMatrix(3, n);
+        aligned &= ((uintptr_t)al.data & (MATRIX_ALIGN - 1)) == 0;
+        if (n >= MATRIX_LINE) aligned &= ((uintptr_t)&MAT(al, 2, 0) & (MATRIX_ALIGN - 1)) == 0;
+        freeMatrix(al);
+    }
+    check(aligned, "storage and rows of 8+ columns are 64-byte aligned");
+    freeMatrix(rows); freeMatrix(blk); freeMatrix(tv);      // views: no-ops
+    freeMatrix(rows_copy); freeMatrix(blk_copy); freeMatrix(tv_copy);
+    freeMatrix(big);
+
+    printf("\n%6s %14s %14s %14s %14s\n", "n", "alloc old us", "alloc new us", "mul old ms", "mul new ms");
+    const unsigned sizes[] = { 16, 64, 255, 256, 512 };
+    for (size_t s = 0; s < sizeof sizes / sizeof *sizes; s++) {
+        unsigned n = sizes[s];
+        int reps = 4096 / n;
+        volatile double sink = 0;
+
+        double t0 = now();
+        for (int r = 0; r < reps; r++) {
+            RowMatrix m = row_init(n, n);
+            for (unsigned i = 0; i < n; i++)
+                for (unsigned j = 0; j < n; j++) m.data[i][j] = i + j;
+            sink += m.data[n - 1][n - 1];
+            row_free(m);
+        }
+        double ta_old = (now() - t0) / reps;
+        t0 = now();
+        for (int r = 0; r < reps; r++) {
+            Matrix m = initMatrix(n, n);
+            for (unsigned i = 0; i < n; i++)
+                for (unsigned j = 0; j < n; j++) MAT(m, i, j) = i + j;
+            sink += MAT(m, n - 1, n - 1);
+            freeMatrix(m);
+        }
+        double ta_new = (now() - t0) / reps;
+
+        RowMatrix ra = row_init(n, n), rb = row_init(n, n);
+        Matrix ma = random_matrix(n, n), mb = random_matrix(n, n);
+        for (unsigned i = 0; i < n; i++)
+            for (unsigned j = 0; j < n; j++) { ra.data[i][j] = MAT(ma, i, j); rb.data[i][j] = MAT(mb, i, j); }
+        t0 = now();
+        RowMatrix rc = row_multiply(ra, rb);
+        double tm_old = now() - t0;
+        t0 = now();
+        Matrix mc = multiply(ma, mb);
+        double tm_new = now() - t0;
+        // entries are in [-1, 1], so each sum is off by at most ~n ulps of n
+        bool same = true;
+        for (unsigned i = 0; i < n; i++)
+            for (unsigned j = 0; j < n; j++) same &= fabs(rc.data[i][j] - MAT(mc, i, j)) <= n * n * 0x1p-52;
+        if (!same) { printf("multiply mismatch at n = %u\n", n); failures++; }
+        printf("%6u %14.2f %14.2f %14.2f %14.2f\n", n, ta_old * 1e6, ta_new * 1e6, tm_old * 1e3, tm_new * 1e3);
+        row_free(ra); row_free(rb); row_free(rc);
+        freeMatrix(ma); freeMatrix(mb); freeMatrix(mc);
+    }
+    return failures != 0;
+}
@@ -0,0 +1,259 @@
+/* Parser and evaluator benchmark over an expression corpus.
+ *
+ * Cases come in four categories: a few trivial expressions, every line of
+ * bench/corpus.txt, deeply nested expressions and very long ones, both
+ * generated here. For each case it reports:
+ *   - latency percentiles (p50/p90/p99) of tokenize(), to_rpn(), the whole
+ *     uncached compile_function() and a cached parse_function(); each
+ *     sample times enough calls to be well above the clock resolution and
+ *     is divided back to a per-call figure;
+ *   - evaluations per second for every evaluator: stack, batch, register
+ *     VM, JIT, float and long double ("-" where one does not apply).
+ * A summary table goes to stdout and every figure to a CSV file, one row
+ * per case, for tracking regressions between releases.
+ *
+ * Usage: ./parser_bench [corpus] [csv]
+ */
+#include <time.h>
+#include <stdarg.h>
+#include "../parser/parser.h"
+#include "../parser/regvm.h"
+#include "../parser/jit.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct { const char *category; char label[48]; char *text; } Case;
+
+typedef struct { char *buf; size_t len, cap; } Str;
+
+static void str_add(Str *s, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (s->len + n + 1 > s->cap) s->buf = realloc(s->buf, s->cap = (s->len + n + 1) * 2);
+    va_start(ap, fmt);
+    vsnprintf(s->buf + s->len, n + 1, fmt, ap);
+    va_end(ap);
+    s->len += n;
+}
+
+static int ncases, capcases;
+static Case *cases;
+
+static void add_case(const char *category, const char *label, char *text) {
+    if (ncases == capcases) cases = realloc(cases, (capcases = capcases ? 2 * capcases : 64) * sizeof *cases);
+    Case *c = &cases[ncases++];
+    c->category = category;
+    snprintf(c->label, sizeof c->label, "%s", label ? label : text);
+    c->text = text;
+}
+
+// sin(cos(sin(...x...))), depth calls deep
+static char *nested_calls(int depth) {
+    Str s = {0};
+    for (int i = 0; i < depth; i++) str_add(&s, i % 2 ? "cos(" : "sin(");
+    str_add(&s, "x");
+    for (int i = 0; i < depth; i++) str_add(&s, ")");
+    return s.buf;
+}
+
+// ((((x+1)*0.5+1)*0.5+1)...), depth parentheses deep
+static char *nested_parens(int depth) {
+    Str s = {0};
+    for (int i = 0; i < depth; i++) str_add(&s, "(");
+    str_add(&s, "x");
+    for (int i = 0; i < depth; i++) str_add(&s, i % 2 ? "*0.5)" : "+1)");
+    return s.buf;
+}
+
+// right-nested quotients: x/(1+x/(2+x/(3+...)))
+static char *continued_fraction(int depth) {
+    Str s = {0};
+    for (int i = 0; i < depth; i++) str_add(&s, "x/(%d+", i + 1);
+    str_add(&s, "x");
+    for (int i = 0; i < depth; i++) str_add(&s, ")");
+    return s.buf;
+}
+
+// c0 + c1*x^1 + ... with terms terms
+static char *long_poly(int terms) {
+    Str s = {0};
+    for (int i = 0; i < terms; i++) str_add(&s, "%s%.6g*x^%d", i ? " + " : "", 1.0 / (i + 1), i % 17);
+    return s.buf;
+}
+
+// sum of terms distinct trigonometric terms
+static char *long_series(int terms) {
+    Str s = {0};
+    for (int i = 0; i < terms; i++) str_add(&s, "%s%.6g*sin(%d*x + %.3g)", i ? " + " : "", 1.0 / (i + 1), i + 1, 0.1 * i);
+    return s.buf;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+enum { SAMPLES = 200 };
+
+// per-call latency percentiles in ns; stage() runs the operation k times
+static void latency(void (*stage)(const char *, int), const char *text, double pct[3]) {
+    double t[SAMPLES];
+    int k = 1;
+    double t0 = now();
+    stage(text, 1);
+    double one = now() - t0;
+    if (one < 2e-6) k = (int)(2e-6 / (one > 1e-8 ? one : 1e-8)) + 1;
+    for (int i = 0; i < SAMPLES; i++) {
+        t0 = now();
+        stage(text, k);
+        t[i] = (now() - t0) / k * 1e9;
+    }
+    qsort(t, SAMPLES, sizeof *t, cmp_double);
+    pct[0] = t[SAMPLES / 2];
+    pct[1] = t[SAMPLES * 9 / 10];
+    pct[2] = t[SAMPLES * 99 / 100];
+}
+
+static const char *const xvar[] = { "x" };
+
+static void stage_tokenize(const char *text, int k) {
+    for (int i = 0; i < k; i++) {
+        int n;
+        ParamTable p = {0};
+        free(tokenize(text, &n, xvar, 1, &p));
+    }
+}
+
+static void stage_to_rpn(const char *text, int k) {
+    int n;
+    ParamTable p = {0};
+    Token *tok = tokenize(text, &n, xvar, 1, &p);
+    for (int i = 0; i < k; i++) {
+        Expr *raw = calloc(1, sizeof *raw);
+        to_rpn(tok, n, raw);
+        expr_free(raw);
+    }
+    free(tok);
+}
+
+static void stage_compile(const char *text, int k) {
+    for (int i = 0; i < k; i++) expr_free(compile_function(text, xvar, 1));
+}
+
+static void stage_cached(const char *text, int k) {
+    for (int i = 0; i < k; i++) expr_free(parse_function(text));
+}
+
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "bench/corpus.txt";
+    const char *csv_path = argc > 2 ? argv[2] : "bench/parser_bench.csv";
+    FILE *in = fopen(path, "r");
+    if (!in) { fprintf(stderr, "cannot open %s\n", path); return 1; }
+
+    const char *trivial[] = { "x", "2", "x+1", "x*x", "sin(x)" };
+    for (size_t i = 0; i < sizeof trivial / sizeof *trivial; i++) add_case("trivial", NULL, strdup(trivial[i]));
+    char line[512];
+    while (fgets(line, sizeof line, in)) {
+        line[strcspn(line, "#\n")] = 0;
+        if (strspn(line, " \t") == strlen(line)) continue;
+        add_case("realistic", NULL, strdup(line));
+    }
+    fclose(in);
+    char label[48];
+    for (int d = 16; d <= 256; d *= 4) {
+        snprintf(label, sizeof label, "sin(cos(...x...)) depth %d", d);
+        add_case("nested", label, nested_calls(d));
+        snprintf(label, sizeof label, "((x+1)*0.5+1)... depth %d", d);
+        add_case("nested", label, nested_parens(d));
+        snprintf(label, sizeof label, "x/(1+x/(2+...)) depth %d", d);
+        add_case("nested", label, continued_fraction(d));
+    }
+    for (int n = 50; n <= 1000; n *= 20) {
+        snprintf(label, sizeof label, "polynomial, %d terms", n);
+        add_case("long", label, long_poly(n));
+        snprintf(label, sizeof label, "sine series, %d terms", n);
+        add_case("long", label, long_series(n));
+    }
+
+    FILE *csv = fopen(csv_path, "w");
+    if (!csv) { fprintf(stderr, "cannot write %s\n", csv_path); return 1; }
+    fprintf(csv, "category,expression,chars,tokens,instrs,depth,slots");
+    const char *stages[] = { "tokenize", "to_rpn", "compile", "cached" };
+    for (int s = 0; s < 4; s++) fprintf(csv, ",%s_p50_ns,%s_p90_ns,%s_p99_ns", stages[s], stages[s], stages[s]);
+    fprintf(csv, ",stack_eval_s,batch_eval_s,regvm_eval_s,jit_eval_s,float_eval_s,ldouble_eval_s\n");
+
+    printf("%-10s %-40s %6s %10s %10s %10s %9s %9s %9s %9s %9s %9s\n", "category", "expression", "instrs",
+           "compile50", "compile99", "cached50", "stack/s", "batch/s", "reg/s", "jit/s", "float/s", "ldbl/s");
+    enum { NX = 1024 };
+    double xs[NX], ys[NX];
+    for (int j = 0; j < NX; j++) xs[j] = 0.5 + 2.5 * j / NX;
+
+    for (int c = 0; c < ncases; c++) {
+        Case *cs = &cases[c];
+        int ntok;
+        ParamTable p = {0};
+        free(tokenize(cs->text, &ntok, xvar, 1, &p));
+        double lat[4][3];
+        latency(stage_tokenize, cs->text, lat[0]);
+        latency(stage_to_rpn, cs->text, lat[1]);
+        latency(stage_compile, cs->text, lat[2]);
+        latency(stage_cached, cs->text, lat[3]);
+
+        const Expr *e = parse_function(cs->text);
+        RegProgram *rp = expr_reg_compile(e);
+        double (*jf)(double) = expr_jit(e);
+        long n = 20000000 / (e->len + 4);
+        n = (n + NX - 1) / NX * NX;
+        volatile long double sink = 0;
+        double rate[6];
+
+        double t0 = now();
+        for (long i = 0; i < n; i++) sink += expr_eval(e, xs[i % NX]);
+        rate[0] = n / (now() - t0);
+        t0 = now();
+        for (long i = 0; i < n; i += NX) { expr_eval_batch(e, xs, ys, NX); sink += ys[0]; }
+        rate[1] = n / (now() - t0);
+        rate[2] = rate[3] = NAN;
+        if (rp) {
+            t0 = now();
+            for (long i = 0; i < n; i++) sink += expr_reg_eval(rp, xs[i % NX]);
+            rate[2] = n / (now() - t0);
+        }
+        if (jf) {
+            t0 = now();
+            for (long i = 0; i < n; i++) sink += jf(xs[i % NX]);
+            rate[3] = n / (now() - t0);
+        }
+        t0 = now();
+        for (long i = 0; i < n; i++) sink += expr_evalf(e, (float)xs[i % NX]);
+        rate[4] = n / (now() - t0);
+        t0 = now();
+        for (long i = 0; i < n; i++) sink += expr_evall(e, xs[i % NX]);
+        rate[5] = n / (now() - t0);
+
+        fprintf(csv, "%s,\"%s\",%zu,%d,%d,%d,%d", cs->category, cs->label, strlen(cs->text), ntok, e->len, e->depth, e->nslots);
+        for (int s = 0; s < 4; s++) fprintf(csv, ",%.1f,%.1f,%.1f", lat[s][0], lat[s][1], lat[s][2]);
+        for (int m = 0; m < 6; m++) isnan(rate[m]) ? fprintf(csv, ",") : fprintf(csv, ",%.4g", rate[m]);
+        fprintf(csv, "\n");
+
+        printf("%-10s %-40.40s %6d %8.2fus %8.2fus %8.0fns", cs->category, cs->label, e->len,
+               lat[2][0] / 1e3, lat[2][2] / 1e3, lat[3][0]);
+        for (int m = 0; m < 6; m++) isnan(rate[m]) ? printf(" %9s", "-") : printf(" %9.3g", rate[m]);
+        printf("\n");
+
+        expr_jit_free(jf);
+        expr_reg_free(rp);
+        expr_free(e);
+        free(cs->text);
+    }
+    fclose(csv);
+    free(cases);
+    printf("\nwrote %s\n", csv_path);
+    return 0;
+}
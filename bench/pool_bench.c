@@ -0,0 +1,160 @@
+/* Matrix kernels on the thread pool: same bits at every thread count.
+ *
+ * multiply(), transpose(), add(), subtract(), scalarMultiply(),
+ * scalarDivide() and cholesky() are run with 1 thread and again with 2, 3,
+ * 4, 7 and 8. Every result must match the 1-thread one bit for bit. Sizes
+ * are picked so that each kernel really splits (cholesky() at n = 1500
+ * gets past the solves' threshold), and odd so the chunks come out uneven.
+ *
+ * cholesky() is also compared with the row-by-row version it replaced,
+ * within rounding, and the table times multiply() at n = 1024 and
+ * cholesky() at n = 1500 for each thread count.
+ *
+ * Exits non-zero if any result differs.
+ *
+ * Usage: ./pool_bench
+ */
+#include <time.h>
+#include <stdint.h>
+#include "../linear_equations/matrix.h"
+#include "../linear_equations/cholesky.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+static Matrix random_matrix(unsigned rows, unsigned cols) {
+    Matrix m = initMatrix(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+        for (unsigned j = 0; j < cols; j++)
+            MAT(m, i, j) = uniform() * 2 - 1;
+    return m;
+}
+
+static bool same_bits(Matrix a, Matrix b) {
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (unsigned i = 0; i < a.rows; i++)
+        if (memcmp(&MAT(a, i, 0), &MAT(b, i, 0), a.cols * sizeof(double))) return false;
+    return true;
+}
+
+// symmetric, diagonally dominant
+static Matrix spd_matrix(unsigned n) {
+    Matrix a = initMatrix(n, n);
+    for (unsigned i = 0; i < n; i++) {
+        for (unsigned j = 0; j < i; j++) MAT(a, i, j) = MAT(a, j, i) = uniform() - 0.5;
+        MAT(a, i, i) = n;
+    }
+    return a;
+}
+
+// cholesky() before the pool: rows of L in order, one sum per element
+static Matrix cholesky_rows(Matrix equations, Matrix constants, double eps) {
+    unsigned n = equations.rows;
+    Matrix L = initMatrix(n, n), y = initMatrix(n, 1), x = initMatrix(n, 1);
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned j = 0; j <= i; j++) {
+            double sum = 0.0;
+            for (unsigned k = 0; k < j; k++) sum += MAT(L, i, k) * MAT(L, j, k);
+            MAT(L, i, j) = i == j ? sqrt(fmax(MAT(equations, i, i) - sum, eps))
+                                  : (1.0 / MAT(L, j, j)) * (MAT(equations, i, j) - sum);
+        }
+    for (unsigned i = 0; i < n; i++) {
+        double sum = 0.0;
+        for (unsigned k = 0; k < i; k++) sum += MAT(L, i, k) * MAT(y, k, 0);
+        MAT(y, i, 0) = (MAT(constants, i, 0) - sum) / MAT(L, i, i);
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = 0.0;
+        for (unsigned k = i + 1; k < n; k++) sum += MAT(L, k, i) * MAT(x, k, 0);
+        MAT(x, i, 0) = (MAT(y, i, 0) - sum) / MAT(L, i, i);
+    }
+    freeMatrix(L); freeMatrix(y);
+    return x;
+}
+
+enum { NRESULTS = 8 };
+
+static void run_all(Matrix a, Matrix b, Matrix sq, Matrix spd, Matrix rhs, Matrix out[NRESULTS]) {
+    out[0] = multiply(a, b);
+    out[1] = multiply(transposeView(b), transposeView(a));
+    out[2] = transpose(sq);
+    out[3] = add(sq, transposeView(sq));
+    out[4] = subtract(sq, transposeView(sq));
+    out[5] = copyMatrix(sq);
+    scalarMultiply(out[5], 1.0 / 3);
+    out[6] = copyMatrix(sq);
+    scalarDivide(out[6], 3);
+    out[7] = cholesky(spd, rhs, 1e-12);
+}
+
+static const char *names[NRESULTS] = {
+    "multiply", "multiply (views)", "transpose", "add", "subtract", "scalarMultiply", "scalarDivide", "cholesky",
+};
+
+int main(void){
+    Matrix a = random_matrix(517, 389), b = random_matrix(389, 603), sq = random_matrix(1031, 1031);
+    Matrix spd = spd_matrix(1500), rhs = random_matrix(1500, 1);
+    int bad = 0;
+
+    Matrix want[NRESULTS], got[NRESULTS];
+    pool_set_threads(1);
+    run_all(a, b, sq, spd, rhs, want);
+
+    Matrix old = cholesky_rows(spd, rhs, 1e-12);
+    double diff = 0;
+    for (unsigned i = 0; i < old.rows; i++) diff = fmax(diff, fabs(MAT(old, i, 0) - MAT(want[7], i, 0)));
+    printf("cholesky vs row-by-row: max diff %.2e\n", diff);
+    bad += !(diff < 1e-15);
+    freeMatrix(old);
+
+    const unsigned counts[] = { 2, 3, 4, 7, 8 };
+    printf("%-18s", "threads");
+    for (size_t c = 0; c < sizeof counts / sizeof *counts; c++) printf(" %6u", counts[c]);
+    printf("\n");
+    bool same[NRESULTS][sizeof counts / sizeof *counts];
+    for (size_t c = 0; c < sizeof counts / sizeof *counts; c++) {
+        pool_set_threads(counts[c]);
+        run_all(a, b, sq, spd, rhs, got);
+        for (int r = 0; r < NRESULTS; r++) {
+            same[r][c] = same_bits(got[r], want[r]);
+            bad += !same[r][c];
+            freeMatrix(got[r]);
+        }
+    }
+    for (int r = 0; r < NRESULTS; r++) {
+        printf("%-18s", names[r]);
+        for (size_t c = 0; c < sizeof counts / sizeof *counts; c++) printf(" %6s", same[r][c] ? "same" : "DIFF");
+        printf("\n");
+        freeMatrix(want[r]);
+    }
+
+    Matrix big1 = random_matrix(1024, 1024), big2 = random_matrix(1024, 1024);
+    printf("\n%8s %14s %14s\n", "threads", "multiply ms", "cholesky ms");
+    const unsigned timed[] = { 1, 2, 4, 8 };
+    for (size_t c = 0; c < sizeof timed / sizeof *timed; c++) {
+        pool_set_threads(timed[c]);
+        double t0 = now();
+        Matrix p = multiply(big1, big2);
+        double tm = now() - t0;
+        t0 = now();
+        Matrix x = cholesky(spd, rhs, 1e-12);
+        double tc = now() - t0;
+        printf("%8u %14.1f %14.1f\n", timed[c], tm * 1e3, tc * 1e3);
+        freeMatrix(p); freeMatrix(x);
+    }
+    pool_set_threads(0);
+
+    freeMatrix(big1); freeMatrix(big2);
+    freeMatrix(a); freeMatrix(b); freeMatrix(sq); freeMatrix(spd); freeMatrix(rhs);
+    return bad != 0;
+}
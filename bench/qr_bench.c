@@ -0,0 +1,189 @@
+/* Householder QR least squares against the normal equations.
+ *
+ * For random m x n matrices (n around the QR_BLOCK boundaries included)
+ * each row gives, in units of m * eps * |A| (max norms):
+ * - |A - QR| and |Q^T Q - I|, with Q built by qr_apply_q();
+ * - |A^T (AX - B)| / (|A| |X| + |B|) for 2 right-hand sides, which is zero
+ *   at the least-squares solution.
+ * Wide matrices (m < n) must give AX = B and the same minimum-norm X as
+ * A^T (A A^T)^-1 B.
+ *
+ * A matrix with a zero column must give an empty solution. The
+ * factorisation must be bit-identical with 1 and 3 threads.
+ *
+ * The conditioning table fits polynomials of rising degree to 200 points
+ * on [0, 1] in the monomial basis, so the condition number climbs fast. The
+ * exact coefficients are all 1. The normal equations square the condition
+ * number and have lost every digit by degree 11. QR loses only what the
+ * problem itself costs.
+ *
+ * The timing table solves tall systems both ways. The normal equations are
+ * formed by hand, the way callers did it before: transpose(), multiply()
+ * and cholesky(). Forming A^T A is one cache-friendly gemm() and comes out
+ * ahead on time; QR pays roughly two to three times that for its accuracy.
+ *
+ * Exits non-zero if a residual goes over 10, or the wide, rank-deficient
+ * or thread check fails, or a polynomial fit by QR is off by more than 1e-4.
+ *
+ * Usage: ./qr_bench
+ */
+#include <time.h>
+#include <stdint.h>
+#include "../linear_equations/matrix.h"
+#include "../linear_equations/cholesky.h"
+#include "../linear_equations/qr.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+static Matrix random_matrix(unsigned rows, unsigned cols) {
+    Matrix m = initMatrix(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+        for (unsigned j = 0; j < cols; j++)
+            MAT(m, i, j) = uniform() * 2 - 1;
+    return m;
+}
+
+static double max_abs(Matrix m) {
+    double r = 0;
+    for (unsigned i = 0; i < m.rows; i++)
+        for (unsigned j = 0; j < m.cols; j++) r = fmax(r, fabs(MAT(m, i, j)));
+    return r;
+}
+
+static Matrix identity(unsigned n) {
+    Matrix id = initMatrix(n, n);
+    for (unsigned i = 0; i < n; i++) MAT(id, i, i) = 1;
+    return id;
+}
+
+// solve A^T A x = A^T b, one right-hand side
+static Matrix normal_equations(Matrix a, Matrix b) {
+    Matrix at = transpose(a), ata = multiply(at, a), atb = multiply(at, b);
+    Matrix x = cholesky(ata, atb, 1e-300);
+    freeMatrix(at); freeMatrix(ata); freeMatrix(atb);
+    return x;
+}
+
+int main(void){
+    int bad = 0;
+    const double eps = 0x1p-52;
+
+    printf("%6s %6s %10s %10s %10s\n", "m", "n", "A-QR", "QtQ-I", "At(AX-B)");
+    const unsigned shapes[][2] = { { 1, 1 }, { 5, 3 }, { 7, 7 }, { 100, 31 }, { 100, 32 }, { 100, 33 },
+                                   { 300, 65 }, { 500, 200 }, { 1000, 100 } };
+    for (size_t s = 0; s < sizeof shapes / sizeof *shapes; s++) {
+        unsigned m = shapes[s][0], n = shapes[s][1];
+        Matrix a = random_matrix(m, n);
+        double na = max_abs(a), scale = m * eps * na;
+        QR f = qr_factor(a);
+
+        Matrix q = identity(m), r = initMatrix(m, n);
+        qr_apply_q(f, q, false);
+        for (unsigned i = 0; i < m && i < n; i++)
+            for (unsigned j = i; j < n; j++) MAT(r, i, j) = MAT(f.qr, i, j);
+        Matrix qr = multiply(q, r), d = subtract(a, qr);
+        double r_qr = max_abs(d) / scale;
+        Matrix qtq = multiply(transposeView(q), q);
+        for (unsigned i = 0; i < m; i++) MAT(qtq, i, i) -= 1;
+        double r_orth = max_abs(qtq) / (m * eps);
+
+        Matrix b = random_matrix(m, 2), x = qr_solve_least_squares(a, b), ax = multiply(a, x), res = subtract(ax, b);
+        Matrix atr = multiply(transposeView(a), res);
+        double r_ls = max_abs(atr) / (scale * (na * max_abs(x) + max_abs(b)));
+
+        printf("%6u %6u %10.3f %10.3f %10.3f\n", m, n, r_qr, r_orth, r_ls);
+        bad += !(r_qr <= 10) + !(r_orth <= 10) + !(r_ls <= 10);
+
+        qr_free(f);
+        freeMatrix(a); freeMatrix(q); freeMatrix(r); freeMatrix(qr); freeMatrix(d); freeMatrix(qtq);
+        freeMatrix(b); freeMatrix(x); freeMatrix(ax); freeMatrix(res); freeMatrix(atr);
+    }
+
+    // wide: the minimum-norm solution, against A^T (A A^T)^-1 B
+    const unsigned wide[][2] = { { 1, 4 }, { 20, 50 }, { 70, 300 } };
+    for (size_t s = 0; s < sizeof wide / sizeof *wide; s++) {
+        unsigned m = wide[s][0], n = wide[s][1];
+        Matrix a = random_matrix(m, n), b = random_matrix(m, 2);
+        Matrix x = qr_solve_least_squares(a, b), ax = multiply(a, x), res = subtract(ax, b);
+        Matrix aat = multiply(a, transposeView(a));
+        LU f = lu_factor(aat);
+        Matrix y = lu_solve(f, b), want = multiply(transposeView(a), y), d = subtract(x, want);
+        double r_res = max_abs(res) / (n * eps * max_abs(a) * max_abs(x)), r_min = max_abs(d) / max_abs(want);
+        printf("wide %ux%u: |AX-B| %.3f, vs A^T (A A^T)^-1 B %.2e\n", m, n, r_res, r_min);
+        bad += !(r_res <= 10) + !(r_min <= 1e-10);
+        lu_free(f);
+        freeMatrix(a); freeMatrix(b); freeMatrix(x); freeMatrix(ax); freeMatrix(res);
+        freeMatrix(aat); freeMatrix(y); freeMatrix(want); freeMatrix(d);
+    }
+
+    // column 1 is zero and stays exactly zero under the reflectors
+    Matrix z = random_matrix(40, 5), zb = random_matrix(40, 1);
+    for (unsigned i = 0; i < 40; i++) MAT(z, i, 1) = 0;
+    Matrix zx = qr_solve_least_squares(z, zb);
+    printf("rank deficient: %s\n", zx.data == NULL ? "ok" : "FAILED");
+    bad += zx.data != NULL;
+    freeMatrix(z); freeMatrix(zb);
+
+    Matrix big = random_matrix(700, 300);
+    pool_set_threads(1);
+    QR f1 = qr_factor(big);
+    pool_set_threads(3);
+    QR f3 = qr_factor(big);
+    pool_set_threads(0);
+    bool ok = true;
+    for (unsigned i = 0; i < 700; i++) ok &= !memcmp(&MAT(f1.qr, i, 0), &MAT(f3.qr, i, 0), 300 * sizeof(double));
+    for (unsigned i = 0; i < f1.t.rows; i++) ok &= !memcmp(&MAT(f1.t, i, 0), &MAT(f3.t, i, 0), 300 * sizeof(double));
+    printf("factorisation, 1 thread vs 3: %s\n", ok ? "same" : "DIFFERENT");
+    bad += !ok;
+    qr_free(f1); qr_free(f3); freeMatrix(big);
+
+    printf("\n%8s %16s %16s\n", "degree", "QR max err", "normal max err");
+    for (unsigned n = 2; n <= 14; n += 2) {
+        unsigned m = 200;
+        Matrix a = initMatrix(m, n), b = initMatrix(m, 1);
+        for (unsigned i = 0; i < m; i++) {
+            double t = (double)i / (m - 1), p = 1;
+            for (unsigned j = 0; j < n; j++, p *= t) {
+                MAT(a, i, j) = p;
+                MAT(b, i, 0) += p;
+            }
+        }
+        Matrix xq = qr_solve_least_squares(a, b), xn = normal_equations(a, b);
+        double eq = 0, en = 0;
+        for (unsigned j = 0; j < n; j++) {
+            eq = fmax(eq, fabs(MAT(xq, j, 0) - 1));
+            en = fmax(en, fabs(MAT(xn, j, 0) - 1));
+        }
+        printf("%8u %16.2e %16.2e\n", n - 1, eq, en);
+        bad += !(eq <= 1e-4);
+        freeMatrix(a); freeMatrix(b); freeMatrix(xq); freeMatrix(xn);
+    }
+
+    printf("\n%6s %6s %14s %14s %14s\n", "m", "n", "normal ms", "QR ms", "QR GFLOP/s");
+    const unsigned timed[][2] = { { 1000, 50 }, { 10000, 100 }, { 4000, 400 }, { 20000, 200 }, { 3000, 1000 } };
+    for (size_t s = 0; s < sizeof timed / sizeof *timed; s++) {
+        unsigned m = timed[s][0], n = timed[s][1];
+        Matrix a = random_matrix(m, n), b = random_matrix(m, 1);
+        double t0 = now();
+        Matrix xn = normal_equations(a, b);
+        double tn = now() - t0;
+        t0 = now();
+        Matrix xq = qr_solve_least_squares(a, b);
+        double tq = now() - t0;
+        double flops = 2.0 * m * n * n - 2.0 / 3 * n * n * n;
+        printf("%6u %6u %14.1f %14.1f %14.2f\n", m, n, tn * 1e3, tq * 1e3, flops / tq * 1e-9);
+        freeMatrix(a); freeMatrix(b); freeMatrix(xn); freeMatrix(xq);
+    }
+    return bad != 0;
+}
@@ -0,0 +1,179 @@
+/* Accuracy and speed of the vector math kernels against libm.
+ *
+ * Each row runs one function over NPTS pseudo-random points in a range,
+ * through vmath_*() and through libm one value at a time. The error
+ * columns give the largest error of each in ulps of the exact result,
+ * taken from the long double libm; "same" is the share of results that
+ * are bit-identical to libm. Then the throughput of both.
+ *
+ * A second pass feeds special values (zeros, infinities, NaN, subnormals,
+ * arguments past each kernel's range) and checks they come out exactly as
+ * libm gives them.
+ *
+ * Last, every expression in bench/corpus.txt is run through the batch
+ * evaluator, which uses these kernels, and through expr_eval(), which uses
+ * libm; the line gives the largest relative difference between the two and
+ * the batch speed-up. Exits non-zero if a kernel goes over the bound
+ * documented in parser/vmath.h, a special value comes out wrong, or the
+ * batch evaluator is off by more than 1e-12.
+ *
+ * Usage: ./vmath_bench [corpus]
+ */
+#include <time.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../parser/parser.h"
+#include "../parser/vmath.h"
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const char *name;
+    void (*vec)(double *, const double *, size_t);
+    double (*scalar)(double);
+    long double (*ref)(long double);
+    double bound;
+} Fn;
+
+static const Fn fns[] = {
+    { "sin",  vmath_sin,  sin,  sinl,  1.0 },
+    { "cos",  vmath_cos,  cos,  cosl,  1.0 },
+    { "tan",  vmath_tan,  tan,  tanl,  2.5 },
+    { "exp",  vmath_exp,  exp,  expl,  1.0 },
+    { "log",  vmath_log,  log,  logl,  1.0 },
+    { "sqrt", vmath_sqrt, sqrt, sqrtl, 0.5 },
+};
+
+// lo, hi bound the range; geometric ranges draw the exponent uniformly
+typedef struct { int fn; double lo, hi; int geometric; } Range;
+
+static const Range ranges[] = {
+    { 0, -M_PI_4, M_PI_4, 0 }, { 0, -100, 100, 0 }, { 0, -1e6, 1e6, 0 },
+    { 1, -M_PI_4, M_PI_4, 0 }, { 1, -100, 100, 0 }, { 1, -1e6, 1e6, 0 },
+    { 2, -M_PI_4, M_PI_4, 0 }, { 2, -100, 100, 0 }, { 2, -1e6, 1e6, 0 },
+    { 3, -1, 1, 0 },           { 3, -700, 700, 0 },
+    { 4, 0.5, 2, 0 },          { 4, 1e-300, 1e300, 1 },
+    { 5, 0, 1e6, 0 },          { 5, 1e-300, 1e300, 1 },
+};
+
+static uint64_t rng = 0x9e3779b97f4a7c15;
+
+static double uniform(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return (rng >> 11) * 0x1p-53;
+}
+
+// error of got in ulps of the exact value ref
+static double ulps(double got, long double ref) {
+    if (isnan(got) || isnan((double)ref)) return isnan(got) && isnan((double)ref) ? 0 : INFINITY;
+    double r = fabs((double)ref), ulp = nextafter(r, INFINITY) - r;
+    if (ulp == 0 || isinf(ulp)) ulp = DBL_TRUE_MIN;
+    return (double)(fabsl(got - ref) / ulp);
+}
+
+static int same_result(double a, double b) {
+    return memcmp(&a, &b, sizeof a) == 0 || (isnan(a) && isnan(b));
+}
+
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "bench/corpus.txt";
+    enum { NPTS = 1 << 20, REPS = 8 };
+    double *xs = malloc(NPTS * sizeof *xs), *yv = malloc(NPTS * sizeof *yv), *ys = malloc(NPTS * sizeof *ys);
+    int bad = 0;
+
+    printf("%-5s %-24s %10s %10s %8s %12s %12s %8s\n", "fn", "range", "vmath ulp", "libm ulp", "same",
+           "vmath Mop/s", "libm Mop/s", "speedup");
+    for (size_t r = 0; r < sizeof ranges / sizeof *ranges; r++) {
+        const Range *rg = &ranges[r];
+        const Fn *f = &fns[rg->fn];
+        for (int i = 0; i < NPTS; i++)
+            xs[i] = rg->geometric ? exp(log(rg->lo) + (log(rg->hi) - log(rg->lo)) * uniform())
+                                  : rg->lo + (rg->hi - rg->lo) * uniform();
+
+        f->vec(yv, xs, NPTS);
+        double ev = 0, es = 0;
+        long same = 0;
+        for (int i = 0; i < NPTS; i++) {
+            long double ref = f->ref(xs[i]);
+            double u = ulps(yv[i], ref), s = ulps(f->scalar(xs[i]), ref);
+            if (u > ev) ev = u;
+            if (s > es) es = s;
+            same += same_result(yv[i], f->scalar(xs[i]));
+        }
+
+        volatile double sink = 0;
+        double t0 = now();
+        for (int k = 0; k < REPS; k++) { f->vec(yv, xs, NPTS); sink += yv[k]; }
+        double tv = now() - t0;
+        t0 = now();
+        for (int k = 0; k < REPS; k++) { for (int i = 0; i < NPTS; i++) ys[i] = f->scalar(xs[i]); sink += ys[k]; }
+        double ts = now() - t0;
+
+        char range[32];
+        snprintf(range, sizeof range, "[%.3g, %.3g]%s", rg->lo, rg->hi, rg->geometric ? " log" : "");
+        printf("%-5s %-24s %10.3f %10.3f %7.2f%% %12.1f %12.1f %7.2fx%s\n", f->name, range, ev, es,
+               100.0 * same / NPTS, REPS * NPTS / tv * 1e-6, REPS * NPTS / ts * 1e-6, ts / tv,
+               ev > f->bound ? "  OVER BOUND" : "");
+        bad += ev > f->bound;
+    }
+
+    const double special[] = {
+        0.0, -0.0, INFINITY, -INFINITY, NAN, -NAN, DBL_TRUE_MIN, -DBL_TRUE_MIN, DBL_MIN, -DBL_MIN,
+        0x1p-1030, DBL_MAX, -DBL_MAX, 1.0, -1.0, 0x1p20, 0x1.0000000000001p20, 1e22, -1e300,
+        708.0, 709.7, 709.79, 710.0, -708.0, -740.0, -745.2, -746.0, 1e-20, -1e-20,
+        M_PI_2, M_PI, 3 * M_PI_2, 2 * M_PI, 6381956970095103.0 * 0x1p797,
+    };
+    enum { NSPECIAL = sizeof special / sizeof *special };
+    int mismatched = 0;
+    for (size_t k = 0; k < sizeof fns / sizeof *fns; k++) {
+        double out[NSPECIAL];
+        fns[k].vec(out, special, NSPECIAL);
+        for (int i = 0; i < NSPECIAL; i++) {
+            double want = fns[k].scalar(special[i]);
+            // finite results may differ within the bound; everything else must match
+            int ok = same_result(out[i], want) ||
+                     (isfinite(want) && want != 0 && ulps(out[i], fns[k].ref(special[i])) <= fns[k].bound);
+            if (!ok) {
+                printf("special: %s(%a) = %a, libm %a\n", fns[k].name, special[i], out[i], want);
+                mismatched++;
+            }
+        }
+    }
+    printf("\nspecial values: %d mismatches\n", mismatched);
+
+    FILE *in = fopen(path, "r");
+    if (!in) { fprintf(stderr, "cannot open %s\n", path); return 1; }
+    char line[512];
+    double worst = 0, t_scalar = 0, t_batch = 0;
+    int nexpr = 0;
+    while (fgets(line, sizeof line, in)) {
+        line[strcspn(line, "#\n")] = 0;
+        if (strspn(line, " \t") == strlen(line)) continue;
+        const Expr *e = parse_function(line);
+        for (int i = 0; i < NPTS; i++) xs[i] = 0.5 + 2.5 * i / NPTS;
+        double t0 = now();
+        for (int i = 0; i < NPTS; i++) ys[i] = expr_eval(e, xs[i]);
+        t_scalar += now() - t0;
+        t0 = now();
+        expr_eval_batch(e, xs, yv, NPTS);
+        t_batch += now() - t0;
+        for (int i = 0; i < NPTS; i++) {
+            double d = fabs(yv[i] - ys[i]) / (fabs(ys[i]) > 1 ? fabs(ys[i]) : 1);
+            if (!(d <= worst) && !(isnan(yv[i]) && isnan(ys[i]))) worst = d;
+        }
+        expr_free(e);
+        nexpr++;
+    }
+    fclose(in);
+    printf("corpus, %d expressions: batch vs expr_eval() max rel diff %.2e, batch %.2fx faster\n",
+           nexpr, worst, t_scalar / t_batch);
+    bad += !(worst <= 1e-12);
+
+    free(xs); free(yv); free(ys);
+    return bad || mismatched;
+}
@@ -1,44 +1,26 @@
 #include <stdio.h>
 #include <math.h>
 
-double bisection_meth(double x0, double x1, double eps, double (*func)(double))
-{
-    double res0 = (*func)(x0);
-    double res1 = (*func)(x1);
-    double pivot;
-
-    if (fabs(res0) <= eps)
-    {
-        return x0;
-    }
-    else if (fabs(res1) <= eps)
-    {
-        return x1;
-    }
-    else if (res0 * res1 >= 0)
-    {
-        printf("ERROR: Cannot detect a root between the intervals! (f(a) * f(b) is equal or bigger than 0)\n");
-        return __INT64_MAX__ + 1;
-    }
-    do
-    {
-        pivot = (x0 + x1) / 2.0;
-        double t = (*func)(pivot);
-        if (t * res0 < 0)
-            x1 = pivot;
-        else if (t * res1 < 0)
-        {
-            x0 = pivot;
-        }
-        else
-        {
-            return pivot;
-        }
-        res0 = (*func)(x0);
-        res1 = (*func)(x1);
 #ifdef DEBUG
-        printf("x0: %lf (%lf) x1: %lf (%lf) pivot: %lf (%lf)\n", x0, res0, x1, res1, pivot, t);
+#define BISECTION_TRACE(...) printf(__VA_ARGS__)
+#else
+#define BISECTION_TRACE(...) ((void)0)
 #endif
-    } while (fabs(x0 - x1) > eps);
-    return pivot;
-}
\ No newline at end of file
+
+// One body for every precision, in bisection_typed.h: bisection_meth() in
+// double, bisection_methf() in float and bisection_methl() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "bisection_typed.h"
+
+#define TYPED_T float
+#define TYPED_SFX f
+#include "bisection_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "bisection_typed.h"
+
+// picks the precision from the type of x0
+#define bisection_meth_tg(x0, x1, eps, func) \
+    _Generic((x0), float: bisection_methf, long double: bisection_methl, default: bisection_meth)(x0, x1, eps, func)
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include "../parser/ddouble.h"
+
+#ifdef DEBUG
+#define BISECTION_TRACE(...) printf(__VA_ARGS__)
+#else
+#define BISECTION_TRACE(...) ((void)0)
+#endif
+
+// The same search carrying double-double state and evaluating func with
+// expr_eval_dd(), for roots of expressions that cancel away the digits
+// double would need to see the sign change; see parser/ddouble.h.
+DDouble bisection_meth_dd(DDouble x0, DDouble x1, DDouble eps, const Expr *func)
+{
+    DDouble res0 = expr_eval_dd(func, x0);
+    DDouble res1 = expr_eval_dd(func, x1);
+    DDouble pivot;
+
+    if (dd_le(dd_abs(res0), eps))
+    {
+        return x0;
+    }
+    else if (dd_le(dd_abs(res1), eps))
+    {
+        return x1;
+    }
+    else if (dd_mul(res0, res1).hi >= 0)
+    {
+        printf("ERROR: Cannot detect a root between the intervals! (f(a) * f(b) is equal or bigger than 0)\n");
+        return dd_from(__INT64_MAX__ + 1);
+    }
+    do
+    {
+        pivot = dd_ldexp(dd_add(x0, x1), -1);
+        DDouble t = expr_eval_dd(func, pivot);
+        if (dd_mul(t, res0).hi < 0)
+            x1 = pivot;
+        else if (dd_mul(t, res1).hi < 0)
+        {
+            x0 = pivot;
+        }
+        else
+        {
+            return pivot;
+        }
+        res0 = expr_eval_dd(func, x0);
+        res1 = expr_eval_dd(func, x1);
+        BISECTION_TRACE("x0: %.17g (%.17g) x1: %.17g (%.17g) pivot: %.17g (%.17g)\n",
+                        x0.hi, res0.hi, x1.hi, res1.hi, pivot.hi, t.hi);
+    } while (dd_lt(eps, dd_abs(dd_sub(x0, x1))));
+    return pivot;
+}
@@ -0,0 +1,47 @@
+/* Bisection template: bisection_meth(), bisection_methf() and bisection_methl(); see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(bisection_meth)(TYPED_T x0, TYPED_T x1, TYPED_T eps, TYPED_T (*func)(TYPED_T))
+{
+    TYPED_T res0 = (*func)(x0);
+    TYPED_T res1 = (*func)(x1);
+    TYPED_T pivot;
+
+    if (TYPED_NAME(fabs)(res0) <= eps)
+    {
+        return x0;
+    }
+    else if (TYPED_NAME(fabs)(res1) <= eps)
+    {
+        return x1;
+    }
+    else if (res0 * res1 >= 0)
+    {
+        printf("ERROR: Cannot detect a root between the intervals! (f(a) * f(b) is equal or bigger than 0)\n");
+        return __INT64_MAX__ + 1;
+    }
+    do
+    {
+        pivot = (x0 + x1) / 2;
+        TYPED_T t = (*func)(pivot);
+        if (t * res0 < 0)
+            x1 = pivot;
+        else if (t * res1 < 0)
+        {
+            x0 = pivot;
+        }
+        else
+        {
+            return pivot;
+        }
+        res0 = (*func)(x0);
+        res1 = (*func)(x1);
+        BISECTION_TRACE("x0: %lf (%lf) x1: %lf (%lf) pivot: %lf (%lf)\n",
+                        (double)x0, (double)res0, (double)x1, (double)res1, (double)pivot, (double)t);
+    } while (TYPED_NAME(fabs)(x0 - x1) > eps);
+    return pivot;
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../parser/interval.h"
+#include "../parser/symbolic.h"
+
+/* A subinterval of the search range that may hold a root. With unique set,
+ * f is defined on all of it, changes sign across it and is strictly
+ * monotone on it, so it holds exactly one root and is a valid bracket for
+ * bisection_meth() and regula_falsi(). Otherwise it is narrower than eps and could not be ruled
+ * out: a double root, a root at the edge, or a near miss. */
+typedef struct { double lo, hi; int unique; } RootBox;
+
+// f certainly has one sign on X: the enclosure misses 0 (or f is undefined there)
+static int iv_no_zero(Interval F) { return iv_empty(F) || F.lo > 0 || F.hi < 0; }
+
+/* Branch and prune over [a, b]: a box whose enclosure of f excludes 0 is
+ * discarded whole; one on which the enclosure of f' excludes 0 is monotone,
+ * so the signs at its ends decide whether it holds one root or none;
+ * anything else is halved until it is narrower than eps. The monotonicity
+ * test only counts where both f and f' are certainly defined and finite on
+ * the whole box: f' from expr_derive() can exist where f does not (the
+ * derivative of log(x) is 1/x), and f may jump over 0 at a gap.
+ *
+ * Stores up to max_out boxes in ascending order in out (adjacent undecided
+ * boxes are merged) and returns how many there were in total. If evals is
+ * not NULL it receives the number of interval evaluations spent. */
+int interval_roots(const Expr *f, double a, double b, double eps, RootBox *out, int max_out, long *evals)
+{
+    const Expr *df = expr_derive(f);
+    int cap = 64, top = 0, found = 0;
+    Interval *stack = malloc(cap * sizeof *stack);
+    long n = 0;
+    RootBox last = {0};
+
+    stack[top++] = (Interval){ a, b };
+    while (top > 0)
+    {
+        Interval X = stack[--top];
+        int f_defined, df_defined;
+        n++;
+        if (iv_no_zero(expr_eval_interval_def(f, X, &f_defined)))
+            continue;
+
+        RootBox box = { X.lo, X.hi, 0 };
+        n++;
+        Interval D = expr_eval_interval_def(df, X, &df_defined);
+        if (f_defined && df_defined && (D.lo > 0 || D.hi < 0))
+        {
+            Interval fa = expr_eval_interval(f, (Interval){ X.lo, X.lo });
+            Interval fb = expr_eval_interval(f, (Interval){ X.hi, X.hi });
+            n += 2;
+            if ((fa.hi < 0 && fb.lo > 0) || (fa.lo > 0 && fb.hi < 0))
+                box.unique = 1;
+            else if ((fa.lo > 0 && fb.lo > 0) || (fa.hi < 0 && fb.hi < 0))
+                continue;
+        }
+
+        double mid = X.lo + (X.hi - X.lo) / 2;
+        if (!box.unique && X.hi - X.lo > eps && mid > X.lo && mid < X.hi)
+        {
+            if (top + 2 > cap)
+                stack = realloc(stack, (cap *= 2) * sizeof *stack);
+            stack[top++] = (Interval){ mid, X.hi };   // right half first, so boxes come out in order
+            stack[top++] = (Interval){ X.lo, mid };
+            continue;
+        }
+
+        if (found > 0 && !box.unique && !last.unique && last.hi == box.lo)
+            last.hi = box.hi;
+        else
+        {
+            last = box;
+            found++;
+        }
+        if (found <= max_out)
+            out[found - 1] = last;
+    }
+    free(stack);
+    expr_free(df);
+    if (evals)
+        *evals = n;
+    return found;
+}
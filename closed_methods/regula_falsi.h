@@ -1,38 +1,20 @@
 #include <math.h>
 #include <stdio.h>
 
-double regula_falsi(double x0, double x1, double eps, double (*func)(double))
-{
-    double res0 = (*func)(x0);
-    double res1 = (*func)(x1);
+// One body for every precision, in regula_falsi_typed.h: regula_falsi() in
+// double, regula_falsif() in float and regula_falsil() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "regula_falsi_typed.h"
 
-    if (fabs(res0) <= eps)
-    {
-        return x0;
-    }
-    else if (fabs(res1) <= eps)
-    {
-        return x1;
-    }
-    else if (res0 * res1 >= 0)
-    {
-        printf("ERROR: Cannot detect a root between the intervals! (f(a) * f(b) is equal or bigger than 0)");
-        return __INT64_MAX__ + 1;
-    }
-    double pos;
-    double res;
+#define TYPED_T float
+#define TYPED_SFX f
+#include "regula_falsi_typed.h"
 
-    do
-    {
-        pos = (x0 * res1 - x1 * res0)/(res1 - res0);
-        res = (*func)(pos);
-        if(res * x0 < 0){
-            x1 = pos;
-            res1 = res;
-        }else{
-            x0 = pos;
-            res0 = res;
-        }
-    } while (fabs(x1 - x0) > eps);
-    return pos;
-}
\ No newline at end of file
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "regula_falsi_typed.h"
+
+// picks the precision from the type of x0
+#define regula_falsi_tg(x0, x1, eps, func) \
+    _Generic((x0), float: regula_falsif, long double: regula_falsil, default: regula_falsi)(x0, x1, eps, func)
@@ -0,0 +1,42 @@
+/* Regula falsi template: regula_falsi(), regula_falsif() and regula_falsil(); see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(regula_falsi)(TYPED_T x0, TYPED_T x1, TYPED_T eps, TYPED_T (*func)(TYPED_T))
+{
+    TYPED_T res0 = (*func)(x0);
+    TYPED_T res1 = (*func)(x1);
+
+    if (TYPED_NAME(fabs)(res0) <= eps)
+    {
+        return x0;
+    }
+    else if (TYPED_NAME(fabs)(res1) <= eps)
+    {
+        return x1;
+    }
+    else if (res0 * res1 >= 0)
+    {
+        printf("ERROR: Cannot detect a root between the intervals! (f(a) * f(b) is equal or bigger than 0)");
+        return __INT64_MAX__ + 1;
+    }
+    TYPED_T pos;
+    TYPED_T res;
+
+    do
+    {
+        pos = (x0 * res1 - x1 * res0)/(res1 - res0);
+        res = (*func)(pos);
+        if(res * x0 < 0){
+            x1 = pos;
+            res1 = res;
+        }else{
+            x0 = pos;
+            res0 = res;
+        }
+    } while (TYPED_NAME(fabs)(x1 - x0) > eps);
+    return pos;
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
@@ -3,6 +3,56 @@
 
 #include "matrix.h"
 
+/* --- Parallel pieces ---
+ * The factorisation goes column by column: L[i][j] for the rows i below the
+ * diagonal are independent, and each is summed exactly as before.
+ *
+ * Each solve goes CHOLESKY_BLOCK unknowns at a time. The block is solved in
+ * order, then the rows still to be solved add its terms to their running
+ * sums s[], shared out over the pool. A row adds its terms in one fixed
+ * order whatever the split: k upwards for L y = b, as the plain loop did,
+ * and k downwards for L^T x = y, the order the x[k] become known.
+ */
+#define CHOLESKY_BLOCK 64
+
+typedef struct {
+    Matrix A, L, y, x;
+    double *s;
+    unsigned j;         // column being factored
+    unsigned k0, k1;    // block just solved
+} CholeskyJob;
+
+static void choleskyColumn(void *arg, size_t begin, size_t end){
+    CholeskyJob *job = arg;
+    Matrix L = job->L;
+    unsigned j = job->j;
+    for (size_t i = j + 1 + begin; i < j + 1 + end; i++) {
+        double sum = 0.0;
+        for (unsigned k = 0; k < j; k++)
+            sum += MAT(L, i, k) * MAT(L, j, k);
+        MAT(L, i, j) = (1.0 / MAT(L, j, j)) * (MAT(job->A, i, j) - sum);
+    }
+}
+
+static void forwardRows(void *arg, size_t begin, size_t end){
+    CholeskyJob *job = arg;
+    for (size_t i = job->k1 + begin; i < job->k1 + end; i++) {
+        double sum = job->s[i];
+        for (unsigned k = job->k0; k < job->k1; k++)
+            sum += MAT(job->L, i, k) * MAT(job->y, k, 0);
+        job->s[i] = sum;
+    }
+}
+
+static void backwardRows(void *arg, size_t begin, size_t end){
+    CholeskyJob *job = arg;
+    for (unsigned k = job->k1; k-- > job->k0; ) {
+        double xk = MAT(job->x, k, 0);
+        for (size_t i = begin; i < end; i++)
+            job->s[i] += MAT(job->L, k, i) * xk;
+    }
+}
+
 Matrix cholesky(const Matrix equations, const Matrix constants, double eps){
     if (equations.rows != equations.cols || equations.rows != constants.rows || constants.cols != 1) {
         printf("Matrix dimension mismatch in cholesky()!\n");
@@ -14,36 +64,57 @@ Matrix cholesky(const Matrix equations, const Matrix constants, double eps){
     Matrix y = initMatrix(n, 1);
     Matrix x = initMatrix(n, 1);
 
+    CholeskyJob job = {.A = equations, .L = L, .y = y, .x = x, .s = calloc(n, sizeof(double))};
+    if (n > 0 && (job.s == NULL || L.data == NULL || y.data == NULL || x.data == NULL)) {
+        printf("WARNING: out of memory in cholesky()!\n");
+        free(job.s);
+        freeMatrix(L);
+        freeMatrix(y);
+        freeMatrix(x);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+
     // Cholesky Ayrıştırması: A = L * L^T
-    for (unsigned i = 0; i < n; i++) {
-        for (unsigned j = 0; j <= i; j++) {
-            double sum = 0.0;
-            for (unsigned k = 0; k < j; k++)
-                sum += L.data[i][k] * L.data[j][k];
-
-            if (i == j)
-                L.data[i][j] = sqrt(fmax(equations.data[i][i] - sum, eps));
-            else
-                L.data[i][j] = (1.0 / L.data[j][j]) * (equations.data[i][j] - sum);
-        }
+    // Column by column, so the rows under each diagonal element can be shared out
+    for (unsigned j = 0; j < n; j++) {
+        double sum = 0.0;
+        for (unsigned k = 0; k < j; k++)
+            sum += MAT(L, j, k) * MAT(L, j, k);
+        MAT(L, j, j) = sqrt(fmax(MAT(equations, j, j) - sum, eps));
+        job.j = j;
+        pool_run(choleskyColumn, &job, n - j - 1, pool_grain(j + 1));
     }
 
     // İleri Yerine Koyma: L * y = b
-    for (unsigned i = 0; i < n; i++) {
-        double sum = 0.0;
-        for (unsigned k = 0; k < i; k++)
-            sum += L.data[i][k] * y.data[k][0];
-        y.data[i][0] = (constants.data[i][0] - sum) / L.data[i][i];
+    for (unsigned k0 = 0; k0 < n; k0 += CHOLESKY_BLOCK) {
+        unsigned k1 = n - k0 < CHOLESKY_BLOCK ? n : k0 + CHOLESKY_BLOCK;
+        for (unsigned i = k0; i < k1; i++) {
+            double sum = job.s[i];
+            for (unsigned k = k0; k < i; k++)
+                sum += MAT(L, i, k) * MAT(y, k, 0);
+            MAT(y, i, 0) = (MAT(constants, i, 0) - sum) / MAT(L, i, i);
+        }
+        job.k0 = k0;
+        job.k1 = k1;
+        pool_run(forwardRows, &job, n - k1, pool_grain(k1 - k0));
     }
 
     // Geri Yerine Koyma: L^T * x = y
-    for (int i = n - 1; i >= 0; i--) {
-        double sum = 0.0;
-        for (unsigned k = i + 1; k < n; k++)
-            sum += L.data[k][i] * x.data[k][0];
-        x.data[i][0] = (y.data[i][0] - sum) / L.data[i][i];
+    memset(job.s, 0, n * sizeof(double));
+    for (unsigned k1 = n, k0; k1 > 0; k1 = k0) {
+        k0 = k1 < CHOLESKY_BLOCK ? 0 : k1 - CHOLESKY_BLOCK;
+        for (unsigned i = k1; i-- > k0; ) {
+            double sum = job.s[i];
+            for (unsigned k = k1 - 1; k > i; k--)
+                sum += MAT(L, k, i) * MAT(x, k, 0);
+            MAT(x, i, 0) = (MAT(y, i, 0) - sum) / MAT(L, i, i);
+        }
+        job.k0 = k0;
+        job.k1 = k1;
+        pool_run(backwardRows, &job, k0, pool_grain(k1 - k0));
     }
 
+    free(job.s);
     freeMatrix(L);
     freeMatrix(y);
     return x;
@@ -19,7 +19,7 @@ Matrix gauss_seidal(const Matrix equations, const Matrix constants, double eps){
             swapped = false;
             for (size_t k = j; k < copy_eque.rows - 1 - j; k++)
             {
-                if(copy_eque.data[j][k] < copy_eque.data[j][k + 1]){
+                if(MAT(copy_eque, j, k) < MAT(copy_eque, j, k + 1)){
                     swapRows(copy_eque, k, k + 1);
                     swapRows(copy_cons, k, k + 1);
                     swapped = true;
@@ -33,27 +33,18 @@ Matrix gauss_seidal(const Matrix equations, const Matrix constants, double eps){
     deltas = malloc(sizeof(double) * copy_eque.rows);
     biggers = malloc(sizeof(double) * copy_eque.rows);
 
+    // Each row, diagonal zeroed and negated, is a view into copy_eque
     for (size_t i = 0; i < copy_eque.rows; i++)
     {
-        // Initialize matrices
-        Matrix mat = initMatrix(1, copy_eque.cols);
-        for (size_t j = 0; j < copy_eque.cols; j++)
-            mat.data[0][j] = copy_eque.data[i][j];
-
-        unsigned *ref;
-        matrices[i].data = mat.data;
-        ref = &matrices[i].rows;
-        *ref = mat.rows;
-        ref = &matrices[i].cols;
-        *ref = mat.cols;
+        matrices[i] = rowRange(copy_eque, i, 1);
 
         // Find the biggest 
-        biggers[i] = matrices[i].data[0][i];
+        biggers[i] = MAT(matrices[i], 0, i);
     
-        matrices[i].data[0][i] = 0;
+        MAT(matrices[i], 0, i) = 0;
         scalarMultiply(matrices[i], -1);
         // Initialize solutions
-        solutions.data[i][0] = 1;
+        MAT(solutions, i, 0) = 1;
     }
     
 
@@ -61,11 +52,13 @@ Matrix gauss_seidal(const Matrix equations, const Matrix constants, double eps){
     do{
         for (size_t i = 0; i < copy_eque.rows; i++)
         {
-            double res = multiply(matrices[i], solutions).data[0][0];
-            res += copy_cons.data[i][0];
+            double res = 0.0;
+            for (size_t j = 0; j < copy_eque.cols; j++)
+                res += MAT(matrices[i], 0, j) * MAT(solutions, j, 0);
+            res += MAT(copy_cons, i, 0);
             res /= biggers[i];
-            deltas[i] = fabs(solutions.data[i][0] - res);
-            solutions.data[i][0] = res;
+            deltas[i] = fabs(MAT(solutions, i, 0) - res);
+            MAT(solutions, i, 0) = res;
         }
         condition = false;
         for (size_t i = 0; (i < copy_eque.rows && condition == false); i++)
@@ -74,11 +67,8 @@ Matrix gauss_seidal(const Matrix equations, const Matrix constants, double eps){
         
     }while(condition);
     
-    for (size_t i = 0; i < copy_eque.rows; i++)
-    {
-        freeMatrix(matrices[i]);
-    }
     freeMatrix(copy_eque);
+    freeMatrix(copy_cons);
     free(matrices);
     free(deltas);
     free(biggers);
@@ -0,0 +1,221 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "thread_pool.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GEMM_X86
+#endif
+
+/* --- Blocking ---
+ * C = A * B the way BLIS does it. B is packed KC x NC at a time into
+ * micro-panels NR columns wide, A MC x KC at a time into micro-panels MR
+ * rows tall, and the micro-kernel keeps an MR x NR tile of C in registers
+ * for the whole KC loop. One A micro-panel and one B micro-panel (KC * (MR
+ * + NR) doubles, 28 KiB) stay in L1, the packed A block (144 KiB) in L2 and
+ * the packed B block in L3. Packing reads A and B through row and column
+ * strides, so views, transposed ones included, go in as they are.
+ */
+#define GEMM_MR 6
+#define GEMM_NR 8
+#define GEMM_KC 256
+#define GEMM_MC 72
+#define GEMM_NC 2048
+
+typedef enum { GEMM_AUTO, GEMM_SCALAR, GEMM_AVX2 } GemmIsa;
+
+// the micro-kernel multiply() uses; GEMM_AUTO picks AVX2/FMA when the CPU has it
+GemmIsa gemm_isa = GEMM_AUTO;
+
+// c (row stride ldc) = (accumulate ? c : 0) + a * b over kc packed steps
+typedef void (*GemmKernel)(size_t kc, const double *a, const double *b, double *c, size_t ldc, bool accumulate);
+
+/* --- Micro-kernels --- */
+
+static void gemm_kernel_scalar(size_t kc, const double *a, const double *b, double *c, size_t ldc, bool accumulate){
+    double acc[GEMM_MR][GEMM_NR] = {{0}};
+    for (size_t p = 0; p < kc; p++, a += GEMM_MR, b += GEMM_NR)
+        for (int i = 0; i < GEMM_MR; i++)
+            for (int j = 0; j < GEMM_NR; j++)
+                acc[i][j] += a[i] * b[j];
+    for (int i = 0; i < GEMM_MR; i++)
+        for (int j = 0; j < GEMM_NR; j++)
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+}
+
+#ifdef GEMM_X86
+// 12 of the 16 ymm registers hold the tile, two take the B row, one the A broadcast
+__attribute__((target("avx2,fma")))
+static void gemm_kernel_avx2(size_t kc, const double *a, const double *b, double *c, size_t ldc, bool accumulate){
+    __m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00;
+    __m256d c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+    for (size_t p = 0; p < kc; p++, a += GEMM_MR, b += GEMM_NR) {
+        __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4), ai;
+        ai = _mm256_broadcast_sd(a + 0); c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1); c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2); c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3); c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+        ai = _mm256_broadcast_sd(a + 4); c40 = _mm256_fmadd_pd(ai, b0, c40); c41 = _mm256_fmadd_pd(ai, b1, c41);
+        ai = _mm256_broadcast_sd(a + 5); c50 = _mm256_fmadd_pd(ai, b0, c50); c51 = _mm256_fmadd_pd(ai, b1, c51);
+    }
+#define GEMM_STORE(i, lo, hi)                                                     \
+    if (accumulate) {                                                             \
+        lo = _mm256_add_pd(lo, _mm256_loadu_pd(c + (i) * ldc));                   \
+        hi = _mm256_add_pd(hi, _mm256_loadu_pd(c + (i) * ldc + 4));               \
+    }                                                                             \
+    _mm256_storeu_pd(c + (i) * ldc, lo);                                          \
+    _mm256_storeu_pd(c + (i) * ldc + 4, hi);
+    GEMM_STORE(0, c00, c01) GEMM_STORE(1, c10, c11) GEMM_STORE(2, c20, c21)
+    GEMM_STORE(3, c30, c31) GEMM_STORE(4, c40, c41) GEMM_STORE(5, c50, c51)
+#undef GEMM_STORE
+}
+#endif
+
+static GemmKernel gemm_kernel(void){
+#ifdef GEMM_X86
+    if (gemm_isa == GEMM_AVX2 || (gemm_isa == GEMM_AUTO && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")))
+        return gemm_kernel_avx2;
+#endif
+    return gemm_kernel_scalar;
+}
+
+/* --- Packing ---
+ * Short panels at the right and bottom edges are padded with zeros, so the
+ * kernel always runs on a full MR x NR tile.
+ */
+
+// alpha is folded into A here; it is exact for the 1 and -1 used in this directory
+static void gemm_pack_a(size_t mc, size_t kc, double alpha, const double *A, size_t rsa, size_t csa, double *buf){
+    for (size_t ir = 0; ir < mc; ir += GEMM_MR) {
+        size_t mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+        for (size_t p = 0; p < kc; p++, buf += GEMM_MR) {
+            size_t i = 0;
+            for (; i < mr; i++) buf[i] = alpha * A[(ir + i) * rsa + p * csa];
+            for (; i < GEMM_MR; i++) buf[i] = 0.0;
+        }
+    }
+}
+
+static void gemm_pack_b(size_t kc, size_t nc, const double *B, size_t rsb, size_t csb, double *buf){
+    for (size_t jr = 0; jr < nc; jr += GEMM_NR) {
+        size_t nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+        for (size_t p = 0; p < kc; p++, buf += GEMM_NR) {
+            size_t j = 0;
+            for (; j < nr; j++) buf[j] = B[p * rsb + (jr + j) * csb];
+            for (; j < GEMM_NR; j++) buf[j] = 0.0;
+        }
+    }
+}
+
+/* --- Driver --- */
+
+// C (+)= alpha * A * B on one slice of rows of C, with its own packing buffers
+static int gemm_block(size_t m, size_t n, size_t k, double alpha, const double *A, size_t rsa, size_t csa,
+                      const double *B, size_t rsb, size_t csb, double *C, size_t ldc, bool add){
+    size_t ncmax = n < GEMM_NC ? (n + GEMM_NR - 1) / GEMM_NR * GEMM_NR : GEMM_NC;
+    size_t kcmax = k < GEMM_KC ? k : GEMM_KC;
+    size_t mcmax = m < GEMM_MC ? (m + GEMM_MR - 1) / GEMM_MR * GEMM_MR : GEMM_MC;
+    // aligned_alloc() wants a multiple of the alignment; ncmax is a multiple of NR already
+    size_t abytes = (mcmax * kcmax * sizeof(double) + 63) & ~(size_t)63;
+    size_t bbytes = kcmax * ncmax * sizeof(double);
+    double *apack = aligned_alloc(64, abytes), *bpack = aligned_alloc(64, bbytes);
+    if (apack == NULL || bpack == NULL) {
+        fprintf(stderr, "WARNING: out of memory for gemm() packing buffers!\n");
+        free(apack);
+        free(bpack);
+        return -1;
+    }
+    GemmKernel kernel = gemm_kernel();
+    double edge[GEMM_MR * GEMM_NR];
+
+    for (size_t jc = 0; jc < n; jc += GEMM_NC) {
+        size_t nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+        for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+            size_t kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+            bool accumulate = add || pc > 0;
+            gemm_pack_b(kc, nc, B + pc * rsb + jc * csb, rsb, csb, bpack);
+            for (size_t ic = 0; ic < m; ic += GEMM_MC) {
+                size_t mc = m - ic < GEMM_MC ? m - ic : GEMM_MC;
+                gemm_pack_a(mc, kc, alpha, A + ic * rsa + pc * csa, rsa, csa, apack);
+                for (size_t jr = 0; jr < nc; jr += GEMM_NR) {
+                    size_t nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+                    for (size_t ir = 0; ir < mc; ir += GEMM_MR) {
+                        size_t mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+                        double *c = C + (ic + ir) * ldc + jc + jr;
+                        const double *a = apack + ir * kc, *b = bpack + jr * kc;
+                        if (mr == GEMM_MR && nr == GEMM_NR) {
+                            kernel(kc, a, b, c, ldc, accumulate);
+                            continue;
+                        }
+                        // edge tile: run the full kernel into a scratch tile, keep the part inside C
+                        kernel(kc, a, b, edge, GEMM_NR, false);
+                        for (size_t i = 0; i < mr; i++)
+                            for (size_t j = 0; j < nr; j++)
+                                c[i * ldc + j] = accumulate ? c[i * ldc + j] + edge[i * GEMM_NR + j] : edge[i * GEMM_NR + j];
+                    }
+                }
+            }
+        }
+    }
+    free(apack);
+    free(bpack);
+    return 0;
+}
+
+typedef struct {
+    size_t n, k;
+    double alpha;
+    const double *A, *B;
+    size_t rsa, csa, rsb, csb;
+    double *C;
+    size_t ldc;
+    bool add;
+    int status;
+} GemmJob;
+
+static void gemm_rows(void *arg, size_t begin, size_t end){
+    GemmJob *job = arg;
+    if (gemm_block(end - begin, job->n, job->k, job->alpha, job->A + begin * job->rsa, job->rsa, job->csa,
+                   job->B, job->rsb, job->csb, job->C + begin * job->ldc, job->ldc, job->add) != 0)
+        __atomic_store_n(&job->status, -1, __ATOMIC_RELAXED);
+}
+
+// rows of C go out over the thread pool in slices of at least MC rows
+static int gemm_run(size_t m, size_t n, size_t k, double alpha, const double *A, size_t rsa, size_t csa,
+                    const double *B, size_t rsb, size_t csb, double *C, size_t ldc, bool add){
+    if (m == 0 || n == 0 || (k == 0 && add))
+        return 0;
+    if (k == 0) {
+        for (size_t i = 0; i < m; i++)
+            memset(C + i * ldc, 0, n * sizeof(double));
+        return 0;
+    }
+    GemmJob job = { n, k, alpha, A, B, rsa, csa, rsb, csb, C, ldc, add, 0 };
+    size_t grain = pool_grain(n * k);
+    grain = grain < GEMM_MC ? GEMM_MC : (grain + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+    pool_run(gemm_rows, &job, m, grain);
+    return job.status;
+}
+
+/* C (m x n, row stride ldc) = A (m x k) * B (k x n). Element (i, j) of A is
+ * A[i * rsa + j * csa], likewise for B. C must not overlap A or B. Each
+ * thread's slice of C packs B for itself; a slice boundary does not change
+ * how any element is summed. Returns -1 if packing buffers cannot be
+ * allocated, 0 otherwise.
+ */
+int gemm(size_t m, size_t n, size_t k, const double *A, size_t rsa, size_t csa,
+         const double *B, size_t rsb, size_t csb, double *C, size_t ldc){
+    return gemm_run(m, n, k, 1.0, A, rsa, csa, B, rsb, csb, C, ldc, false);
+}
+
+// C += alpha * A * B, otherwise as gemm()
+int gemm_update(size_t m, size_t n, size_t k, double alpha, const double *A, size_t rsa, size_t csa,
+                const double *B, size_t rsb, size_t csb, double *C, size_t ldc){
+    return gemm_run(m, n, k, alpha, A, rsa, csa, B, rsb, csb, C, ldc, true);
+}
+
+#endif
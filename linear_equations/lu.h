@@ -0,0 +1,216 @@
+#include "matrix.h"
+
+#ifndef LU_H
+#define LU_H
+
+/* --- LU factorisation ---
+ * P A = L U with partial pivoting, in place. U sits on and above the
+ * diagonal, and L below it with its unit diagonal not stored. Row i of the
+ * factors is row perm[i] of A.
+ *
+ * It works right-looking, LU_BLOCK columns at a time. Each panel is
+ * factored column by column, swapping whole rows as pivots are picked. The
+ * block row to the right is then solved against the panel's L, and the
+ * trailing matrix gets one gemm_update(). Nearly all the work lands in the
+ * gemm kernel and the thread pool.
+ *
+ * matrix.h includes this file part-way down, where determinant() and
+ * inverse() need it. matrix.h is included above the guard so that
+ * including lu.h first still gets that order.
+ */
+#define LU_BLOCK 64
+
+typedef struct {
+    Matrix lu;
+    unsigned *perm;
+    int sign;           // of the permutation, for the determinant
+    bool singular;      // some pivot was exactly zero
+} LU;
+
+typedef struct {
+    Matrix a, x;
+    unsigned j, jb;     // panel being applied to the block row, or diagonal block being solved
+} LUJob;
+
+// the block row right of the panel: U12 = L11^-1 A12, split by columns
+static void luBlockRow(void *arg, size_t begin, size_t end){
+    LUJob *job = arg;
+    Matrix a = job->a;
+    size_t c0 = job->j + job->jb + begin, c1 = job->j + job->jb + end;
+    for (unsigned r = job->j + 1; r < job->j + job->jb; r++)
+        for (unsigned q = job->j; q < r; q++) {
+            double l = MAT(a, r, q);
+            for (size_t c = c0; c < c1; c++)
+                MAT(a, r, c) -= l * MAT(a, q, c);
+        }
+}
+
+// unblocked factorisation of the panel of columns [j, j + jb), rows j and below
+static unsigned luPanel(Matrix a, unsigned j, unsigned jb, unsigned *perm, int *sign){
+    unsigned n = a.rows, zeros = 0;
+    for (unsigned c = j; c < j + jb; c++) {
+        unsigned p = c;
+        for (unsigned i = c + 1; i < n; i++)
+            if (fabs(MAT(a, i, c)) > fabs(MAT(a, p, c)))
+                p = i;
+        if (p != c) {
+            swapRows(a, c, p);
+            unsigned t = perm[c];
+            perm[c] = perm[p];
+            perm[p] = t;
+            *sign = -*sign;
+        }
+        double pivot = MAT(a, c, c);
+        if (pivot == 0.0) {
+            zeros++;
+            continue;
+        }
+        for (unsigned i = c + 1; i < n; i++) {
+            double l = MAT(a, i, c) /= pivot;
+            for (unsigned k = c + 1; k < j + jb; k++)
+                MAT(a, i, k) -= l * MAT(a, c, k);
+        }
+    }
+    return zeros;
+}
+
+/* Factors the square matrix a in place. perm (a.rows entries) and *sign
+ * receive the row permutation. The rows of a must be contiguous (step 1),
+ * as in anything from initMatrix() or a row or block view of it. Returns -1
+ * if a is not square or its rows are not contiguous, else the number of
+ * zero pivots met (0 when a is nonsingular).
+ */
+int lu_decompose(Matrix a, unsigned *perm, int *sign){
+    if (a.rows != a.cols || (a.rows > 1 && a.step != 1)) {
+        fprintf(stderr, "WARNING: lu_decompose() wants a square matrix with contiguous rows, got %ux%u!\n", a.rows, a.cols);
+        return -1;
+    }
+    unsigned n = a.rows, zeros = 0;
+    for (unsigned i = 0; i < n; i++)
+        perm[i] = i;
+    *sign = 1;
+    for (unsigned j = 0; j < n; j += LU_BLOCK) {
+        unsigned jb = n - j < LU_BLOCK ? n - j : LU_BLOCK, rest = n - j - jb;
+        zeros += luPanel(a, j, jb, perm, sign);
+        if (rest == 0)
+            break;
+        LUJob job = {.a = a, .j = j, .jb = jb};
+        pool_run(luBlockRow, &job, rest, pool_grain(jb * jb / 2));
+        // A22 -= L21 * U12
+        gemm_update(rest, rest, jb, -1.0, &MAT(a, j + jb, j), a.stride, 1, &MAT(a, j, j + jb), a.stride, 1,
+                    &MAT(a, j + jb, j + jb), a.stride);
+    }
+    return (int)zeros;
+}
+
+// factors a copy of mat; lu.data is NULL and perm NULL if mat is not square
+LU lu_factor(Matrix mat){
+    LU f = {.sign = 1};
+    if (mat.rows != mat.cols || (mat.rows > 0 && mat.data == NULL)) {
+        printf("WARNING: lu_factor() needs a square matrix, got %ux%u => Empty factorisation returned!\n", mat.rows, mat.cols);
+        return f;
+    }
+    f.lu = copyMatrix(mat);
+    f.perm = malloc((mat.rows ? mat.rows : 1) * sizeof(unsigned));
+    if (f.perm == NULL || (mat.rows > 0 && f.lu.data == NULL)) {
+        printf("WARNING: out of memory in lu_factor() => Empty factorisation returned!\n");
+        freeMatrix(f.lu);
+        free(f.perm);
+        return (LU){.sign = 1};
+    }
+    f.singular = lu_decompose(f.lu, f.perm, &f.sign) != 0;
+    return f;
+}
+
+void lu_free(LU f){
+    freeMatrix(f.lu);
+    free(f.perm);
+}
+
+double lu_det(LU f){
+    double det = f.sign;
+    for (unsigned i = 0; i < f.lu.rows; i++)
+        det *= MAT(f.lu, i, i);
+    return det;
+}
+
+// forward substitution against the diagonal block [j, j + jb) of L, on a slice of the columns of x
+static void luLowerColumns(void *arg, size_t begin, size_t end){
+    LUJob *job = arg;
+    Matrix a = job->a, x = job->x;
+    for (unsigned i = job->j + 1; i < job->j + job->jb; i++)
+        for (unsigned k = job->j; k < i; k++) {
+            double l = MAT(a, i, k);
+            for (size_t c = begin; c < end; c++)
+                MAT(x, i, c) -= l * MAT(x, k, c);
+        }
+}
+
+// back substitution against the diagonal block [j, j + jb) of U, likewise
+static void luUpperColumns(void *arg, size_t begin, size_t end){
+    LUJob *job = arg;
+    Matrix a = job->a, x = job->x;
+    for (unsigned i = job->j + job->jb; i-- > job->j; ) {
+        for (unsigned k = i + 1; k < job->j + job->jb; k++) {
+            double u = MAT(a, i, k);
+            for (size_t c = begin; c < end; c++)
+                MAT(x, i, c) -= u * MAT(x, k, c);
+        }
+        double d = MAT(a, i, i);
+        for (size_t c = begin; c < end; c++)
+            MAT(x, i, c) /= d;
+    }
+}
+
+/* X with A X = B, for every column of b at once. Both substitutions go
+ * LU_BLOCK rows at a time: the diagonal block is solved directly, split by
+ * columns of X, and the rows still to come are updated with gemm_update().
+ */
+Matrix lu_solve(LU f, Matrix b){
+    unsigned n = f.lu.rows;
+    if (f.perm == NULL || b.rows != n) {
+        printf("WARNING: lu_solve() got no factorisation or %u right-hand rows for %u unknowns => Empty matrix returned!\n", b.rows, n);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    if (f.singular) {
+        printf("WARNING: matrix is singular in lu_solve() => Empty matrix returned!\n");
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    Matrix a = f.lu, x = initMatrix(n, b.cols);
+    if (x.data == NULL)
+        return x;
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned c = 0; c < b.cols; c++)
+            MAT(x, i, c) = MAT(b, f.perm[i], c);
+
+    // L Y = P B
+    for (unsigned j = 0; j < n; j += LU_BLOCK) {
+        unsigned jb = n - j < LU_BLOCK ? n - j : LU_BLOCK, rest = n - j - jb;
+        LUJob job = {.a = a, .x = x, .j = j, .jb = jb};
+        pool_run(luLowerColumns, &job, x.cols, pool_grain(jb * jb / 2));
+        if (rest > 0)
+            gemm_update(rest, x.cols, jb, -1.0, &MAT(a, j + jb, j), a.stride, a.step, &MAT(x, j, 0), x.stride, 1,
+                        &MAT(x, j + jb, 0), x.stride);
+    }
+    // U X = Y
+    for (unsigned j1 = n, j; j1 > 0; j1 = j) {
+        j = j1 < LU_BLOCK ? 0 : j1 - LU_BLOCK;
+        LUJob job = {.a = a, .x = x, .j = j, .jb = j1 - j};
+        pool_run(luUpperColumns, &job, x.cols, pool_grain(job.jb * job.jb / 2));
+        if (j > 0)
+            gemm_update(j, x.cols, j1 - j, -1.0, &MAT(a, 0, j), a.stride, a.step, &MAT(x, j, 0), x.stride, 1,
+                        &MAT(x, 0, 0), x.stride);
+    }
+    return x;
+}
+
+Matrix lu_inverse(LU f){
+    Matrix id = initMatrix(f.lu.rows, f.lu.rows);
+    for (unsigned i = 0; i < id.rows; i++)
+        MAT(id, i, i) = 1.0;
+    Matrix ret = lu_solve(f, id);
+    freeMatrix(id);
+    return ret;
+}
+
+#endif
@@ -3,15 +3,45 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include "thread_pool.h"
+#include "gemm.h"
+
+/* --- Storage ---
+ * A matrix is one 64-byte-aligned block. Element (i, j) lives at
+ * data[i * stride + j * step]: stride is the leading dimension, step is 1
+ * except in transposed views, where the two trade places. Views share the
+ * block of the matrix they come from and have owner == NULL, so freeMatrix()
+ * leaves them alone; they must not outlive that matrix.
+ *
+ * Rows of 8 or more columns start on a cache line. A stride that is a
+ * multiple of 1 KiB gets one more line, or walking down a column keeps
+ * landing in the same few cache sets.
+ */
+#define MATRIX_ALIGN 64
+#define MATRIX_LINE (MATRIX_ALIGN / sizeof(double))
+
+size_t matrixStride(unsigned col){
+    if (col < MATRIX_LINE)
+        return col;
+    size_t stride = (col + MATRIX_LINE - 1) / MATRIX_LINE * MATRIX_LINE;
+    return stride % (16 * MATRIX_LINE) ? stride : stride + MATRIX_LINE;
+}
 
 typedef struct sMat{
-    double **data;
+    double *data;
     unsigned rows;
     unsigned cols;
+    size_t stride;
+    size_t step;
+    double *owner;
 } Matrix;
 
+#define MAT(m, i, j) ((m).data[(size_t)(i) * (m).stride + (size_t)(j) * (m).step])
+
 int ipow(int num, unsigned pow){
     int res = 1;
     while(pow-- > 0) res*=num;
@@ -41,34 +71,105 @@ Matrix swapRows(Matrix mat, unsigned row1, unsigned row2){
     }
     
     for (size_t i = 0; i < mat.cols; i++)
-        fswap(&mat.data[row1][i], &mat.data[row2][i]);
+        fswap(&MAT(mat, row1, i), &MAT(mat, row2, i));
     return mat;
 } 
 
 Matrix initMatrix(unsigned row, unsigned col){
-    Matrix mat;
-    mat.data = malloc(sizeof(double*) * row);
-    for (size_t i = 0; i < row; i++)
-    {
-        mat.data[i] = calloc(col, sizeof(double));
+    Matrix mat = {.rows = row, .cols = col, .stride = matrixStride(col), .step = 1};
+    size_t bytes = (size_t)row * mat.stride * sizeof(double);
+    if (bytes == 0)
+        return mat;
+    // calloc() hands back fresh pages already zeroed, which aligned_alloc() + memset() would touch
+    mat.owner = calloc(bytes + MATRIX_ALIGN, 1);
+    if (mat.owner == NULL) {
+        fprintf(stderr, "WARNING: out of memory for a %ux%u matrix!\n", row, col);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
-    unsigned *ref = &mat.rows; 
-    *ref = row;
-    ref = &mat.cols;
-    *ref = col;
+    mat.data = (double *)(((uintptr_t)mat.owner + MATRIX_ALIGN - 1) & ~(uintptr_t)(MATRIX_ALIGN - 1));
     return mat;
 }
 
 void setDataMatrix(Matrix mat, double *data){
     for (size_t i = 0; i < mat.rows; i++)
         for (size_t j = 0; j < mat.cols; j++)
-            mat.data[i][j] = data[(i * mat.cols) + j];
+            MAT(mat, i, j) = data[(i * mat.cols) + j];
 }
 
 void freeMatrix(Matrix mat){
-    for (size_t i = 0; i < mat.rows; i++)
-        free(mat.data[i]);
-    free(mat.data);
+    free(mat.owner);
+}
+
+/* --- Views --- */
+
+// rows [first, first + count) of mat
+Matrix rowRange(Matrix mat, unsigned first, unsigned count){
+    if (first > mat.rows || count > mat.rows - first) {
+        fprintf(stderr, "WARNING: rowRange out of range! rows %u..%u in %ux%u\n", first, first + count, mat.rows, mat.cols);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    Matrix ret = mat;
+    ret.data = count ? &MAT(mat, first, 0) : NULL;
+    ret.rows = count;
+    ret.owner = NULL;
+    return ret;
+}
+
+// the rows x cols block whose top-left element is (i, j)
+Matrix subBlock(Matrix mat, unsigned i, unsigned j, unsigned rows, unsigned cols){
+    if (i > mat.rows || j > mat.cols || rows > mat.rows - i || cols > mat.cols - j) {
+        fprintf(stderr, "WARNING: subBlock out of range! %ux%u at (%u,%u) in %ux%u\n", rows, cols, i, j, mat.rows, mat.cols);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    Matrix ret = mat;
+    ret.data = rows && cols ? &MAT(mat, i, j) : NULL;
+    ret.rows = rows;
+    ret.cols = cols;
+    ret.owner = NULL;
+    return ret;
+}
+
+Matrix transposeView(Matrix mat){
+    Matrix ret = mat;
+    ret.rows = mat.cols;
+    ret.cols = mat.rows;
+    ret.stride = mat.step;
+    ret.step = mat.stride;
+    ret.owner = NULL;
+    return ret;
+}
+
+/* --- Element-wise kernels ---
+ * dst = a op b (or a op num) row by row, rows shared out over the thread
+ * pool. dst may be a itself.
+ */
+
+typedef enum { ELEM_COPY, ELEM_ADD, ELEM_SUB, ELEM_MUL, ELEM_DIV } ElemOp;
+
+typedef struct {
+    Matrix dst, a, b;
+    double num;
+    ElemOp op;
+} ElemJob;
+
+static void elemRows(void *arg, size_t begin, size_t end){
+    ElemJob *job = arg;
+    Matrix d = job->dst, a = job->a, b = job->b;
+    double num = job->num;
+    for (size_t i = begin; i < end; i++) {
+        switch (job->op) {
+        case ELEM_COPY: for (size_t j = 0; j < d.cols; j++) MAT(d, i, j) = MAT(a, i, j); break;
+        case ELEM_ADD:  for (size_t j = 0; j < d.cols; j++) MAT(d, i, j) = MAT(a, i, j) + MAT(b, i, j); break;
+        case ELEM_SUB:  for (size_t j = 0; j < d.cols; j++) MAT(d, i, j) = MAT(a, i, j) - MAT(b, i, j); break;
+        case ELEM_MUL:  for (size_t j = 0; j < d.cols; j++) MAT(d, i, j) = MAT(a, i, j) * num; break;
+        case ELEM_DIV:  for (size_t j = 0; j < d.cols; j++) MAT(d, i, j) = MAT(a, i, j) / num; break;
+        }
+    }
+}
+
+static void elemRun(ElemJob job){
+    if (job.dst.data != NULL)
+        pool_run(elemRows, &job, job.dst.rows, pool_grain(job.dst.cols));
 }
 
 void printMatrix(Matrix mat){
@@ -76,7 +177,7 @@ void printMatrix(Matrix mat){
     {
         printf("| ");
         for (size_t j = 0; j < mat.cols; j++)
-            printf("%.3lf ", mat.data[i][j]);
+            printf("%.3lf ", MAT(mat, i, j));
         printf("\t|\n");
     }
     printf("\n");
@@ -84,22 +185,19 @@ void printMatrix(Matrix mat){
 
 Matrix copyMatrix(Matrix mat){
     Matrix ret = initMatrix(mat.rows, mat.cols);
-    for (size_t i = 0; i < mat.rows; i++)
-        for (size_t j = 0; j < mat.cols; j++)
-            ret.data[i][j] = mat.data[i][j];
+    // ret is empty if it could not be allocated
+    for (size_t i = 0; i < ret.rows; i++)
+        for (size_t j = 0; j < ret.cols; j++)
+            MAT(ret, i, j) = MAT(mat, i, j);
     return ret;
 }
 
 void scalarMultiply(Matrix mat, double num){
-    for (size_t i = 0; i < mat.rows; i++)
-        for (size_t j = 0; j < mat.cols; j++)
-            mat.data[i][j] *= num;
+    elemRun((ElemJob){.dst = mat, .a = mat, .num = num, .op = ELEM_MUL});
 }
 
 void scalarDivide(Matrix mat, double num){
-    for (size_t i = 0; i < mat.rows; i++)
-        for (size_t j = 0; j < mat.cols; j++)
-            mat.data[i][j] /= num;
+    elemRun((ElemJob){.dst = mat, .a = mat, .num = num, .op = ELEM_DIV});
 }
 
 Matrix add(Matrix mat1, Matrix mat2){
@@ -107,10 +205,8 @@ Matrix add(Matrix mat1, Matrix mat2){
         printf("WARNING: data == NULL OR dimensions mismatch for add() => Empty matrix returned!\n");
         return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
-    Matrix ret = copyMatrix(mat1);
-    for (size_t i = 0; i < mat1.rows; i++)
-        for (size_t j = 0; j < mat1.cols; j++)
-            ret.data[i][j] += mat2.data[i][j];
+    Matrix ret = initMatrix(mat1.rows, mat1.cols);
+    elemRun((ElemJob){.dst = ret, .a = mat1, .b = mat2, .op = ELEM_ADD});
     return ret;
 }
 
@@ -119,10 +215,8 @@ Matrix subtract(Matrix mat1, Matrix mat2){
         printf("WARNING: data == NULL OR dimensions mismatch for subtract() => Empty matrix returned!\n");
         return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
-    Matrix ret = copyMatrix(mat1);
-    for (size_t i = 0; i < mat1.rows; i++)
-        for (size_t j = 0; j < mat1.cols; j++)
-            ret.data[i][j] -= mat2.data[i][j];
+    Matrix ret = initMatrix(mat1.rows, mat1.cols);
+    elemRun((ElemJob){.dst = ret, .a = mat1, .b = mat2, .op = ELEM_SUB});
     return ret;
 }
 
@@ -132,33 +226,25 @@ Matrix multiply(Matrix mat1, Matrix mat2){
         return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
     Matrix ret = initMatrix(mat1.rows, mat2.cols);
-    double res = 0.0;
-    for (size_t y = 0; y < ret.rows; y++)
-    {
-        for (size_t x = 0; x < ret.cols; x++)
-        {
-            res = 0.0;
-            for (size_t i = 0; i < mat1.cols; i++)
-                res += mat1.data[y][i] * mat2.data[i][x];
-            ret.data[y][x] = res;
-        }
-
+    if (ret.data != NULL && gemm(ret.rows, ret.cols, mat1.cols, mat1.data, mat1.stride, mat1.step,
+                                 mat2.data, mat2.stride, mat2.step, ret.data, ret.stride) < 0) {
+        printf("WARNING: gemm() failed in multiply() => Empty matrix returned!\n");
+        freeMatrix(ret);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
     return ret;
 }
 
 Matrix transpose(Matrix mat){
     Matrix ret_mat = initMatrix(mat.cols, mat.rows);
-    for (size_t i = 0; i < mat.rows; i++)
-        for (size_t j = 0; j < mat.cols; j++)
-            ret_mat.data[j][i] = mat.data[i][j];
+    elemRun((ElemJob){.dst = ret_mat, .a = transposeView(mat), .op = ELEM_COPY});
     return ret_mat;
 }
 
 Matrix submat(Matrix mat, unsigned i, unsigned j){
     if (i >= mat.rows || j >= mat.cols || mat.data == NULL) {
         fprintf(stderr, "WARNING: submat indices out of range! (%u,%u) in %ux%u\n", i, j, mat.rows, mat.cols);
-        return (Matrix){0,0,NULL};
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
     }
     Matrix ret = initMatrix(mat.rows - 1, mat.cols - 1);
     unsigned y = 0, x;
@@ -167,7 +253,7 @@ Matrix submat(Matrix mat, unsigned i, unsigned j){
         x = 0;
         for (unsigned jj = 0; jj < mat.cols; jj++) {
             if (jj == j) continue;
-            ret.data[y][x++] = mat.data[ii][jj];
+            MAT(ret, y, x++) = MAT(mat, ii, jj);
         }
         y++;
     }
@@ -175,24 +261,16 @@ Matrix submat(Matrix mat, unsigned i, unsigned j){
 }
 
 
+#include "lu.h"
+
 double determinant(Matrix mat){
     if(mat.cols != mat.rows){
         printf("WARNING: rows != columns for determinant() => Overflow returned\n");
         return __INT64_MAX__ + 1;
     }
-    if (mat.cols == 1) {
-        return mat.data[0][0];
-    }
-    if(mat.cols == 2){
-        return (mat.data[0][0] * mat.data[1][1]) - (mat.data[0][1] * mat.data[1][0]);
-    }
-    double res = 0.0f;
-    for (size_t j = 0; j < mat.cols; j++)
-    {
-        Matrix sub = submat(mat, 0, j);
-        res += ipow(-1, j) * mat.data[0][j] * determinant(sub);
-        freeMatrix(sub);
-    }
+    LU f = lu_factor(mat);
+    double res = lu_det(f);
+    lu_free(f);
     return res;
 }
 
@@ -203,7 +281,7 @@ Matrix cofactor(Matrix mat){
         for (size_t j = 0; j < mat.cols; j++)
         {
             Matrix sub = submat(mat, i, j);
-            ret.data[i][j] = ipow(-1, i+j) * determinant(sub);
+            MAT(ret, i, j) = ipow(-1, i+j) * determinant(sub);
             freeMatrix(sub);
         }   
     }
@@ -218,10 +296,10 @@ Matrix adjoint(Matrix mat){
 }
 
 Matrix inverse(Matrix mat){
-    Matrix adj = adjoint(mat);
-    double deter = determinant(mat);
-    scalarDivide(adj, deter);
-    return adj;
+    LU f = lu_factor(mat);
+    Matrix ret = lu_inverse(f);
+    lu_free(f);
+    return ret;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,381 @@
+#ifndef QR_H
+#define QR_H
+
+#include "matrix.h"
+
+/* --- Householder QR ---
+ * A = Q R for any m x n A, in place. R sits on and above the diagonal and
+ * the Householder vectors below it; each vector's leading 1 is not stored.
+ * The first k = min(m, n) columns each give one reflector
+ * H_i = I - tau_i v_i v_i^T.
+ *
+ * It goes QR_BLOCK columns at a time. A panel is factored one reflector at
+ * a time. Its reflectors are then gathered into the compact WY form
+ * H_j ... H_{j+b-1} = I - V T V^T, with T upper triangular. The rest of the
+ * matrix is updated with two gemm() calls instead of b rank-1 updates. The
+ * T of every block is kept, side by side in a QR_BLOCK x k matrix, so Q can
+ * be applied again later at the same cost.
+ */
+#define QR_BLOCK 64
+// panels no wider than this are factored a reflector at a time
+#define QR_PANEL 8
+
+typedef struct {
+    Matrix qr;
+    Matrix t;
+} QR;
+
+typedef struct {
+    Matrix t, w;
+    bool trans;
+} QRJob;
+
+// 2-norm of column c from row r0 down, scaled so squares cannot overflow
+static double qrNorm(Matrix a, unsigned c, unsigned r0){
+    double scale = 0.0, ssq = 1.0;
+    for (unsigned i = r0; i < a.rows; i++) {
+        double x = fabs(MAT(a, i, c));
+        if (x == 0.0)
+            continue;
+        if (scale < x) {
+            ssq = 1.0 + ssq * (scale / x) * (scale / x);
+            scale = x;
+        } else
+            ssq += (x / scale) * (x / scale);
+    }
+    return scale * sqrt(ssq);
+}
+
+/* Reflector for column c, rows c down: afterwards a[c][c] is beta and the
+ * rows below hold v without its leading 1. Returns tau, 0 when the column
+ * is already zero below the diagonal.
+ */
+static double qrHouse(Matrix a, unsigned c){
+    double alpha = MAT(a, c, c), xnorm = qrNorm(a, c, c + 1);
+    if (xnorm == 0.0)
+        return 0.0;
+    double beta = -copysign(hypot(alpha, xnorm), alpha);
+    double scale = 1.0 / (alpha - beta);
+    for (unsigned i = c + 1; i < a.rows; i++)
+        MAT(a, i, c) *= scale;
+    MAT(a, c, c) = beta;
+    return (beta - alpha) / beta;
+}
+
+// top jb x jb of the block's V written out: unit diagonal, zeros above it
+static Matrix qrTop(Matrix a, unsigned j, unsigned jb){
+    Matrix top = initMatrix(jb, jb);
+    for (unsigned i = 0; top.data != NULL && i < jb; i++) {
+        for (unsigned c = 0; c < i; c++)
+            MAT(top, i, c) = MAT(a, j + i, j + c);
+        MAT(top, i, i) = 1.0;
+    }
+    return top;
+}
+
+/* W = V^T C for the block [j, j + jb), where C has the rows j and below.
+ * Below its top V is stored in a as it is, so gemm() reads it in place.
+ * Returns -1 if gemm() fails, 0 otherwise.
+ */
+static int qrVtC(Matrix a, unsigned j, Matrix top, Matrix c, Matrix w){
+    unsigned jb = top.rows, below = c.rows - jb;
+    if (gemm(jb, c.cols, jb, top.data, top.step, top.stride, c.data, c.stride, c.step, w.data, w.stride) < 0)
+        return -1;
+    if (below > 0)
+        return gemm_update(jb, c.cols, below, 1.0, &MAT(a, j + jb, j), a.step, a.stride, &MAT(c, jb, 0), c.stride, c.step,
+                           w.data, w.stride);
+    return 0;
+}
+
+/* W = op(T) W on a slice of the columns of W, a row at a time in the order
+ * that only reads rows not yet overwritten
+ */
+static void qrTriangleColumns(void *arg, size_t begin, size_t end){
+    QRJob *job = arg;
+    Matrix t = job->t, w = job->w;
+    unsigned jb = t.rows;
+    for (unsigned s = 0; s < jb; s++) {
+        unsigned i = job->trans ? jb - 1 - s : s;
+        double d = MAT(t, i, i), *wi = &MAT(w, i, 0);
+        for (size_t c = begin; c < end; c++)
+            wi[c] *= d;
+        for (unsigned k = job->trans ? 0 : i + 1; k < (job->trans ? i : jb); k++) {
+            double tik = job->trans ? MAT(t, k, i) : MAT(t, i, k);
+            const double *wk = &MAT(w, k, 0);
+            for (size_t c = begin; c < end; c++)
+                wi[c] += tik * wk[c];
+        }
+    }
+}
+
+/* c = (I - V op(T) V^T) c for the block [j, j + jb), where op(T) is T^T
+ * when trans is set (that applies the block's part of Q^T) and T otherwise
+ * (Q). c holds rows j and below, and its rows must be contiguous. Returns
+ * -1 if memory runs out, in which case c may be partly updated, 0 otherwise.
+ */
+static int qrApplyBlock(Matrix a, unsigned j, Matrix t, Matrix c, bool trans){
+    unsigned jb = t.rows, below = c.rows - jb;
+    Matrix top = qrTop(a, j, jb), w = initMatrix(jb, c.cols);
+    int status = top.data == NULL || w.data == NULL ? -1 : qrVtC(a, j, top, c, w);
+    if (status == 0) {
+        QRJob job = {.t = t, .w = w, .trans = trans};
+        pool_run(qrTriangleColumns, &job, w.cols, pool_grain(jb * jb / 2));
+        // C -= V W
+        status = gemm_update(jb, c.cols, jb, -1.0, top.data, top.stride, top.step, w.data, w.stride, 1, c.data, c.stride);
+        if (status == 0 && below > 0)
+            status = gemm_update(below, c.cols, jb, -1.0, &MAT(a, j + jb, j), a.stride, a.step, w.data, w.stride, 1,
+                                 &MAT(c, jb, 0), c.stride);
+    }
+    if (status < 0)
+        fprintf(stderr, "WARNING: out of memory in qrApplyBlock()!\n");
+    freeMatrix(top);
+    freeMatrix(w);
+    return status;
+}
+
+// factors the narrow panel [j, j + jb) one reflector at a time and builds its T
+static void qrPanelColumns(Matrix a, unsigned j, unsigned jb, Matrix t){
+    unsigned m = a.rows;
+    double w[QR_PANEL];
+    for (unsigned c = j; c < j + jb; c++) {
+        double tau = qrHouse(a, c);
+        MAT(t, c - j, c - j) = tau;
+        if (tau == 0.0)
+            continue;
+        // the rest of the panel: A -= tau v (v^T A), row by row so rows are read whole
+        unsigned rest = j + jb - c - 1;
+        double *top = &MAT(a, c, c + 1);
+        for (unsigned k = 0; k < rest; k++)
+            w[k] = top[k];
+        for (unsigned i = c + 1; i < m; i++) {
+            const double *row = &MAT(a, i, c + 1);
+            double vi = row[-1];
+            for (unsigned k = 0; k < rest; k++)
+                w[k] += vi * row[k];
+        }
+        for (unsigned k = 0; k < rest; k++) {
+            w[k] *= tau;
+            top[k] -= w[k];
+        }
+        for (unsigned i = c + 1; i < m; i++) {
+            double *row = &MAT(a, i, c + 1), vi = row[-1];
+            for (unsigned k = 0; k < rest; k++)
+                row[k] -= vi * w[k];
+        }
+    }
+
+    /* T: column q above the diagonal is -tau_q T[0:q, 0:q] s, s = V[:, 0:q]^T v_q.
+     * v_q is 0 above row j + q and 1 on it, so s[p] is a[j+q][j+p] plus the
+     * products of the rows below.
+     */
+    double s[QR_PANEL][QR_PANEL] = { 0 };
+    for (unsigned i = j + 2; i < m; i++) {
+        const double *row = &MAT(a, i, j);
+        unsigned lim = i - j < jb ? i - j : jb;
+        for (unsigned q = 1; q < lim; q++)
+            for (unsigned p = 0; p < q; p++)
+                s[p][q] += row[p] * row[q];
+    }
+    for (unsigned q = 1; q < jb; q++) {
+        double tau = MAT(t, q, q);
+        for (unsigned p = 0; p < q; p++)
+            s[p][q] += MAT(a, j + q, j + p);
+        for (unsigned r = 0; r < q; r++) {
+            double sum = 0.0;
+            for (unsigned k = r; k < q; k++)
+                sum += MAT(t, r, k) * s[k][q];
+            MAT(t, r, q) = -tau * sum;
+        }
+    }
+}
+
+/* Factors the panel [j, j + jb) and fills its jb x jb T. A panel wider than
+ * QR_PANEL is split in two: the left half is factored and applied to the
+ * right half, the right half is factored, and the two T join up as
+ * T12 = -T11 (V1^T V2) T22. All but the narrowest strips go through gemm(),
+ * and those strips stay in cache however tall the matrix is. Returns -1 if
+ * memory runs out, 0 otherwise.
+ */
+static int qrPanel(Matrix a, unsigned j, unsigned jb, Matrix t){
+    if (jb <= QR_PANEL) {
+        qrPanelColumns(a, j, jb, t);
+        return 0;
+    }
+    unsigned m = a.rows, h = jb / 2, r = jb - h;
+    Matrix t11 = subBlock(t, 0, 0, h, h), t12 = subBlock(t, 0, h, h, r), t22 = subBlock(t, h, h, r, r);
+    if (qrPanel(a, j, h, t11) < 0 || qrApplyBlock(a, j, t11, subBlock(a, j, j + h, m - j, r), true) < 0
+        || qrPanel(a, j + h, r, t22) < 0)
+        return -1;
+
+    // (V1^T V2)^T = V2^T V1, and V2 is zero above row j + h so V1 counts from there on
+    Matrix top = qrTop(a, j + h, r), x = initMatrix(r, h);
+    if (top.data == NULL || x.data == NULL || qrVtC(a, j + h, top, subBlock(a, j + h, j, m - j - h, h), x) < 0) {
+        fprintf(stderr, "WARNING: out of memory in qrPanel()!\n");
+        freeMatrix(top);
+        freeMatrix(x);
+        return -1;
+    }
+    for (unsigned i = 0; i < h; i++)
+        for (unsigned c = 0; c < r; c++)
+            MAT(t12, i, c) = MAT(x, c, i);
+    QRJob job = {.t = t11, .w = t12};
+    qrTriangleColumns(&job, 0, r);
+    // times -T22, right to left along each row
+    for (unsigned i = 0; i < h; i++) {
+        double *row = &MAT(t12, i, 0);
+        for (unsigned c = r; c-- > 0; ) {
+            double sum = 0.0;
+            for (unsigned k = 0; k <= c; k++)
+                sum += row[k] * MAT(t22, k, c);
+            row[c] = -sum;
+        }
+    }
+    freeMatrix(top);
+    freeMatrix(x);
+    return 0;
+}
+
+/* Factors a (m x n) in place and writes each block's T into t, which must
+ * be min(QR_BLOCK, k) x k. The rows of a must be contiguous, as in anything
+ * from initMatrix() or a row or block view of it. Returns -1 on bad
+ * arguments or when memory runs out, 0 otherwise.
+ */
+int qr_decompose(Matrix a, Matrix t){
+    unsigned m = a.rows, n = a.cols, k = m < n ? m : n;
+    if ((k > 1 && a.step != 1) || t.cols != k || t.rows != (k < QR_BLOCK ? k : QR_BLOCK)) {
+        fprintf(stderr, "WARNING: qr_decompose() wants contiguous rows and a %ux%u T!\n", k < QR_BLOCK ? k : QR_BLOCK, k);
+        return -1;
+    }
+    for (unsigned j = 0; j < k; j += QR_BLOCK) {
+        unsigned jb = k - j < QR_BLOCK ? k - j : QR_BLOCK;
+        Matrix tb = subBlock(t, 0, j, jb, jb);
+        if (qrPanel(a, j, jb, tb) < 0)
+            return -1;
+        if (j + jb < n && qrApplyBlock(a, j, tb, subBlock(a, j, j + jb, m - j, n - j - jb), true) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+void qr_free(QR f){
+    freeMatrix(f.qr);
+    freeMatrix(f.t);
+}
+
+// factors a copy of mat; both matrices are empty if that fails
+QR qr_factor(Matrix mat){
+    unsigned k = mat.rows < mat.cols ? mat.rows : mat.cols;
+    QR f = {.qr = copyMatrix(mat), .t = initMatrix(k < QR_BLOCK ? k : QR_BLOCK, k)};
+    if (f.qr.data == NULL || f.t.data == NULL || qr_decompose(f.qr, f.t) < 0) {
+        printf("WARNING: qr_factor() failed => Empty factorisation returned!\n");
+        qr_free(f);
+        return (QR){.qr = {.rows = 0, .cols = 0, .data = NULL}, .t = {.rows = 0, .cols = 0, .data = NULL}};
+    }
+    return f;
+}
+
+/* c = Q^T c when trans is set, else Q c; c has the m rows of the factored
+ * matrix. Returns -1 on bad arguments or when memory runs out, 0 otherwise.
+ */
+int qr_apply_q(QR f, Matrix c, bool trans){
+    unsigned m = f.qr.rows, k = f.t.cols;
+    if (f.qr.data == NULL || c.data == NULL || c.rows != m || (c.cols > 1 && c.step != 1)) {
+        printf("WARNING: qr_apply_q() got %u rows for a %u-row Q, or non-contiguous rows!\n", c.rows, m);
+        return -1;
+    }
+    unsigned nblocks = (k + QR_BLOCK - 1) / QR_BLOCK;
+    for (unsigned b = 0; b < nblocks; b++) {
+        // Q = H_0 H_1 ... H_{k-1}, so Q^T takes the blocks first to last and Q last to first
+        unsigned j = (trans ? b : nblocks - 1 - b) * QR_BLOCK, jb = k - j < QR_BLOCK ? k - j : QR_BLOCK;
+        if (qrApplyBlock(f.qr, j, subBlock(f.t, 0, j, jb, jb), rowRange(c, j, m - j), trans) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+// 0 if some diagonal element of R is zero, i.e. A does not have full rank
+static bool qrFullRank(QR f){
+    for (unsigned i = 0; i < f.t.cols; i++)
+        if (MAT(f.qr, i, i) == 0.0) {
+            printf("WARNING: matrix is rank deficient in QR (R[%u][%u] = 0) => Empty matrix returned!\n", i, i);
+            return false;
+        }
+    return true;
+}
+
+/* X minimising |A X - B| column by column, for the tall (m >= n) A that f
+ * was factored from: R X = (Q^T B)[0:n].
+ */
+Matrix qr_solve(QR f, Matrix b){
+    unsigned m = f.qr.rows, n = f.qr.cols;
+    if (f.qr.data == NULL || m < n || b.rows != m) {
+        printf("WARNING: qr_solve() wants m >= n and %u rows in b, got %ux%u and %u => Empty matrix returned!\n", m, m, n, b.rows);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    if (!qrFullRank(f))
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    Matrix y = copyMatrix(b);
+    if (qr_apply_q(f, y, true) < 0) {
+        freeMatrix(y);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    Matrix x = initMatrix(n, b.cols);
+    for (unsigned i = x.data == NULL ? 0 : n; i-- > 0; ) {
+        for (unsigned c = 0; c < b.cols; c++)
+            MAT(x, i, c) = MAT(y, i, c);
+        for (unsigned k = i + 1; k < n; k++) {
+            double r = MAT(f.qr, i, k);
+            for (unsigned c = 0; c < b.cols; c++)
+                MAT(x, i, c) -= r * MAT(x, k, c);
+        }
+        for (unsigned c = 0; c < b.cols; c++)
+            MAT(x, i, c) /= MAT(f.qr, i, i);
+    }
+    freeMatrix(y);
+    return x;
+}
+
+/* Least-squares solution of A X = B for any m x n A of full rank. When
+ * m >= n it minimises |A X - B|. When m < n there are many exact
+ * solutions and it returns the one of least norm: with A^T = Q R,
+ * X = Q [R^-T B; 0].
+ */
+Matrix qr_solve_least_squares(Matrix a, Matrix b){
+    if (a.rows != b.rows || a.rows == 0 || a.cols == 0) {
+        printf("WARNING: qr_solve_least_squares() got %ux%u and %u rows in b => Empty matrix returned!\n", a.rows, a.cols, b.rows);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    if (a.rows >= a.cols) {
+        QR f = qr_factor(a);
+        Matrix x = qr_solve(f, b);
+        qr_free(f);
+        return x;
+    }
+    unsigned m = a.rows, n = a.cols;
+    QR f = qr_factor(transposeView(a));
+    if (f.qr.data == NULL || !qrFullRank(f)) {
+        qr_free(f);
+        return (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    // R^T z = b into the top m rows of x, zeros below, then x = Q x
+    Matrix x = initMatrix(n, b.cols);
+    for (unsigned i = 0; x.data != NULL && i < m; i++) {
+        for (unsigned c = 0; c < b.cols; c++)
+            MAT(x, i, c) = MAT(b, i, c);
+        for (unsigned k = 0; k < i; k++) {
+            double r = MAT(f.qr, k, i);
+            for (unsigned c = 0; c < b.cols; c++)
+                MAT(x, i, c) -= r * MAT(x, k, c);
+        }
+        for (unsigned c = 0; c < b.cols; c++)
+            MAT(x, i, c) /= MAT(f.qr, i, i);
+    }
+    if (qr_apply_q(f, x, false) < 0) {
+        freeMatrix(x);
+        x = (Matrix){.rows = 0, .cols = 0, .data = NULL};
+    }
+    qr_free(f);
+    return x;
+}
+
+#endif
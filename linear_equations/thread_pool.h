@@ -0,0 +1,186 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* --- Thread pool ---
+ * pool_run() cuts [0, n) into one contiguous chunk per thread, none shorter
+ * than grain items. It runs chunk 0 on the calling thread and the rest on
+ * workers that sleep between calls, and it returns once every chunk is done.
+ * Each kernel in this directory gives every output element to exactly one
+ * chunk and computes it the same way in any chunk, so the thread count does
+ * not change results.
+ *
+ * The thread count comes from pool_set_threads(), else MATRIX_THREADS in
+ * the environment, else the number of online CPUs. A call made from inside
+ * a chunk, or while another thread holds the pool, runs inline.
+ */
+#define POOL_MAX_THREADS 256
+// multiply-adds a chunk should have before it is worth waking a thread for
+#define POOL_GRAIN_WORK (1 << 15)
+
+typedef void (*PoolTask)(void *arg, size_t begin, size_t end);
+
+static struct {
+    pthread_mutex_t lock, busy;
+    pthread_cond_t wake, done;
+    pthread_t workers[POOL_MAX_THREADS];
+    unsigned nthreads;          // counting the caller; 0 until first asked
+    unsigned nworkers;          // started so far
+    unsigned long generation;   // bumped for every job
+    unsigned long base;         // generation when the workers were started
+    PoolTask fn;
+    void *arg;
+    size_t n, grain;
+    unsigned nchunks, pending;
+    bool quit;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER, .busy = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER, .done = PTHREAD_COND_INITIALIZER,
+};
+
+static _Thread_local bool pool_inside;
+
+// items per chunk for a kernel doing work multiply-adds per item
+static inline size_t pool_grain(size_t work){
+    return work >= POOL_GRAIN_WORK ? 1 : (POOL_GRAIN_WORK + work - 1) / (work ? work : 1);
+}
+
+static void pool_chunk(unsigned c, unsigned nchunks, size_t n, size_t grain, size_t *begin, size_t *end){
+    size_t units = (n + grain - 1) / grain;
+    *begin = units * c / nchunks * grain;
+    *end = units * (c + 1) / nchunks * grain;
+    if (*end > n)
+        *end = n;
+}
+
+static void *pool_worker(void *p){
+    unsigned id = (unsigned)(uintptr_t)p;
+    pool_inside = true;
+    pthread_mutex_lock(&pool.lock);
+    unsigned long seen = pool.base;
+    for (;;) {
+        while (pool.generation == seen && !pool.quit)
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.quit)
+            break;
+        seen = pool.generation;
+        if (id >= pool.nchunks)
+            continue;
+        size_t begin, end;
+        PoolTask fn = pool.fn;
+        void *arg = pool.arg;
+        pool_chunk(id, pool.nchunks, pool.n, pool.grain, &begin, &end);
+        pthread_mutex_unlock(&pool.lock);
+        fn(arg, begin, end);
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0)
+            pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// stops and joins the workers; the caller holds pool.busy
+static void pool_stop(void){
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = true;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    for (unsigned i = 1; i <= pool.nworkers; i++)
+        pthread_join(pool.workers[i], NULL);
+    pool.quit = false;
+    pool.nworkers = 0;
+}
+
+static unsigned pool_default_threads(void){
+    const char *env = getenv("MATRIX_THREADS");
+    long n = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : n > POOL_MAX_THREADS ? POOL_MAX_THREADS : (unsigned)n;
+}
+
+// 0 goes back to the default; waits for a pool_run() in progress
+void pool_set_threads(unsigned n){
+    pthread_mutex_lock(&pool.busy);
+    pool_stop();
+    pool.nthreads = n == 0 ? pool_default_threads() : n > POOL_MAX_THREADS ? POOL_MAX_THREADS : n;
+    pthread_mutex_unlock(&pool.busy);
+}
+
+static void pool_init(void){
+    pthread_mutex_lock(&pool.busy);
+    if (pool.nthreads == 0)
+        pool.nthreads = pool_default_threads();
+    pthread_mutex_unlock(&pool.busy);
+}
+
+unsigned pool_threads(void){
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, pool_init);
+    return pool.nthreads;
+}
+
+void pool_run(PoolTask fn, void *arg, size_t n, size_t grain){
+    if (grain == 0)
+        grain = 1;
+    size_t units = (n + grain - 1) / grain;
+    unsigned nthreads = pool_threads();
+    unsigned nchunks = units < nthreads ? (unsigned)units : nthreads;
+    if (nchunks <= 1 || pool_inside || pthread_mutex_trylock(&pool.busy) != 0) {
+        if (n > 0)
+            fn(arg, 0, n);
+        return;
+    }
+
+    if (pool.nworkers + 1 < pool.nthreads) {
+        pool.base = pool.generation;
+        while (pool.nworkers + 1 < pool.nthreads) {
+            unsigned id = pool.nworkers + 1;
+            if (pthread_create(&pool.workers[id], NULL, pool_worker, (void *)(uintptr_t)id) != 0) {
+                fprintf(stderr, "WARNING: could not start thread %u, pool stays at %u!\n", id, id);
+                pool.nthreads = id;
+                break;
+            }
+            pool.nworkers = id;
+        }
+    }
+    // pool_set_threads() may have shrunk the pool since nthreads was read
+    if (nchunks > pool.nthreads)
+        nchunks = pool.nthreads;
+    if (nchunks <= 1) {
+        pthread_mutex_unlock(&pool.busy);
+        fn(arg, 0, n);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.n = n;
+    pool.grain = grain;
+    pool.nchunks = nchunks;
+    pool.pending = nchunks - 1;
+    pool.generation++;
+    if (pool.pending > 0)
+        pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    size_t begin, end;
+    pool_chunk(0, nchunks, n, grain, &begin, &end);
+    pool_inside = true;
+    fn(arg, begin, end);
+    pool_inside = false;
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.pending > 0)
+        pthread_cond_wait(&pool.done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.busy);
+}
+
+#endif
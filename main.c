@@ -17,6 +17,7 @@
 
 #include "data_structures/general_data_structures.h"
 #include "parser/parser.h"
+#include "parser/symbolic.h"
 
 
 /* Helper to compute factorial */
@@ -106,9 +107,14 @@ int main(){
                     expr[strcspn(expr, "\n")] = 0; 
                 
                     // 2) parse & solve
-                    double (*f)(double) = parse_function(expr);
-                    double root = bisection_meth(x0, x1, 1e-8, f);
-                    if(root != __INT64_MAX__ + 1) printf("x ~= %.8f\n", root);
+                    const Expr *f = parse_function(expr);
+                    double (*fn)(double) = expr_bind(f);
+                    if (fn == NULL) printf("Could not evaluate f(x).\n");
+                    else {
+                        double root = bisection_meth(x0, x1, 1e-8, fn);
+                        if(root != __INT64_MAX__ + 1) printf("x ~= %.8f\n", root);
+                    }
+                    expr_free(f);
                 
                     // 3) ask to repeat
                     printf("Try another equation? (Y/n): ");
@@ -133,9 +139,14 @@ int main(){
                     expr[strcspn(expr, "\n")] = 0; 
                 
                     // 2) parse & solve
-                    double (*f)(double) = parse_function(expr);
-                    double root = regula_falsi(x0, x1, 1e-8, f);
-                    if(root != __INT64_MAX__ + 1) printf("x ~= %.8f\n", root);
+                    const Expr *f = parse_function(expr);
+                    double (*fn)(double) = expr_bind(f);
+                    if (fn == NULL) printf("Could not evaluate f(x).\n");
+                    else {
+                        double root = regula_falsi(x0, x1, 1e-8, fn);
+                        if(root != __INT64_MAX__ + 1) printf("x ~= %.8f\n", root);
+                    }
+                    expr_free(f);
                 
                     // 3) ask to repeat
                     printf("Try another equation? (Y/n): ");
@@ -157,24 +168,23 @@ int main(){
                         fgets(buf, sizeof(buf), stdin);
                         sscanf(buf, "%lf", &x0);
                         
-                        // 2) read & save f(x)
+                        // 2) read f(x)
                         printf("Enter f(x): ");
                         fgets(buf, sizeof(buf), stdin);
                         buf[strcspn(buf, "\n")] = 0;
-                        parse_function(buf);            // builds rpn[] for f
-                        save_current_rpn(&rpn_f, &rpn_len_f);
+                        const Expr *f = parse_function(buf);
                         
-                        // 3) read & save f'(x)
-                        printf("Enter f'(x): ");
-                        fgets(buf, sizeof(buf), stdin);
-                        buf[strcspn(buf, "\n")] = 0;
-                        parse_function(buf);            // rebuilds rpn[] for f′
-                        save_current_rpn(&rpn_fder, &rpn_len_fder);
+                        // 3) derive f'(x) symbolically and show it
+                        const Expr *fder = expr_derive(f);
+                        printf("f'(x) = ");
+                        expr_print(fder, stdout);
                         
-                        // 4) call Newton–Raphson with our wrappers
-                        double root = newton_raphton(x0, eps, call_f, call_fder);
+                        // 4) Newton–Raphson, taking f and f' from one dual-number pass over f
+                        double root = newton_raphton_expr(x0, eps, f);
                         if (root != __INT64_MAX__ + 1)
                             printf("x ~= %.8f\n", root);
+                        expr_free(f);
+                        expr_free(fder);
                         // 3) ask to repeat
                         printf("Try another equation? (Y/n): ");
                         fgets(ans, sizeof(ans), stdin);
@@ -238,13 +248,13 @@ int main(){
                         fgets(line,sizeof(line),stdin);
                         char* p=line;
                         for(int j=0;j<m;j++){
-                            A.data[i][j]=strtod(p,&p);
+                            MAT(A, i, j)=strtod(p,&p);
                         }
                     }
                     bool is_symmetric = true;
                     for(int i=0;i<m;i++)
                       for(int j=0;j<m;j++)
-                        if (fabs(A.data[i][j] - A.data[j][i]) > 1e-12)
+                        if (fabs(MAT(A, i, j) - MAT(A, j, i)) > 1e-12)
                           is_symmetric = false;
                     if (!is_symmetric) {
                       printf("Error: matrix must be symmetric positive-definite for Cholesky.\n");
@@ -252,7 +262,7 @@ int main(){
                         printf("Enter %d entries for b:\n", m);
                         for(int i=0;i<m;i++){
                             fgets(line,sizeof(line),stdin);
-                            bvec.data[i][0]=strtod(line,NULL);
+                            MAT(bvec, i, 0)=strtod(line,NULL);
                         }
                         printf("DEBUG: A =\n"); printMatrix(A);
                         printf("DEBUG: b =\n"); printMatrix(bvec);
@@ -277,8 +287,8 @@ int main(){
                         fgets(line,sizeof(line),stdin);
                         char* p = line;
                         for(int j=0;j<m;j++) 
-                            A.data[i][j]=strtod(p,&p);
-                        bvec.data[i][0]=strtod(p,NULL);
+                            MAT(A, i, j)=strtod(p,&p);
+                        MAT(bvec, i, 0)=strtod(p,NULL);
                     }
                     Matrix sol = gauss_seidal(A,bvec,1e-8);
                     printf("Solution vector x:\n"); printMatrix(sol);
@@ -292,14 +302,18 @@ int main(){
                     printf("Enter function f(x): ");
                     double a, b;
                     fgets(expr,sizeof(expr),stdin); expr[strcspn(expr,"\n")]=0;
-                    double (*f)(double)=parse_function(expr);
-                    for (int i = 0; i < rpn_len; ++i)
-                      printf("%s ", rpn[i]);
-                    printf("\n");
+                    const Expr *f=parse_function(expr);
+                    expr_dump(f, stdout);
                     printf("Enter point x0 and epsilon (Ex: 3.53 2.321): ");
                     fgets(line,sizeof(line),stdin); sscanf(line,"%lf %lf",&x0,&a);
-                    double d = central_diff_derivative(x0,a,f);
-                    printf("f'(%.4f) ~= %.8f\n", x0, d);
+                    double (*fn)(double) = expr_bind(f);
+                    if (fn == NULL) printf("Could not evaluate f(x).\n");
+                    else {
+                        double d = central_diff_derivative(x0,a,fn);
+                        printf("f'(%.4f) ~= %.8f\n", x0, d);
+                        printf("complex step: f'(%.4f) = %.15g\n", x0, complex_step_derivative(f, x0, 1e-100));
+                    }
+                    expr_free(f);
                     printf("Try another? (Y/n): "); fgets(ans,sizeof(ans),stdin);
                     cont=ans[0]==0?'y':ans[0];
                 }
@@ -312,11 +326,14 @@ int main(){
                     unsigned n;
                     fgets(line,sizeof(line),stdin); sscanf(line,"%lf %lf %u",&a,&b,&n);
                     printf("Enter function f(x): "); fgets(expr,sizeof(expr),stdin); expr[strcspn(expr,"\n")]=0;
-                    double (*f2)(double)=parse_function(expr);
-                    double res1 = simpson_1_3_integration(a,b,n,f2);
-                    double res2 = simpson_3_8_integration(a,b,n,f2);
-                    printf("Simpson 1/3 result: %.8f\n", res1);
-                    printf("Simpson 3/8 result: %.8f\n", res2);
+                    const Expr *f2=parse_function(expr);
+                    double (*fn)(double) = expr_bind(f2);
+                    if (fn == NULL) printf("Could not evaluate f(x).\n");
+                    else {
+                        printf("Simpson 1/3 result: %.8f\n", simpson_1_3_integration(a,b,n,fn));
+                        printf("Simpson 3/8 result: %.8f\n", simpson_3_8_integration(a,b,n,fn));
+                    }
+                    expr_free(f2);
                     printf("Try another? (Y/n): "); fgets(ans,sizeof(ans),stdin);
                     cont=ans[0]==0?'y':ans[0];
                 }
@@ -329,9 +346,11 @@ int main(){
                     printf("Enter a b and number of trapezoids n: ");
                     fgets(line,sizeof(line),stdin); sscanf(line,"%lf %lf %u",&a,&b,&n);
                     printf("Enter function f(x): "); fgets(expr,sizeof(expr),stdin); expr[strcspn(expr,"\n")]=0;
-                    double (*f3)(double)=parse_function(expr);
-                    double res = trapezoidal_integration(a,b,n,f3);
-                    printf("Trapezoidal result: %.8f\n", res);
+                    const Expr *f3=parse_function(expr);
+                    double (*fn)(double) = expr_bind(f3);
+                    if (fn == NULL) printf("Could not evaluate f(x).\n");
+                    else printf("Trapezoidal result: %.8f\n", trapezoidal_integration(a,b,n,fn));
+                    expr_free(f3);
                     printf("Try another? (Y/n): "); fgets(ans,sizeof(ans),stdin);
                     cont=ans[0]==0?'y':ans[0];
                 }
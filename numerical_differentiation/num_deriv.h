@@ -1,4 +1,5 @@
 #include <math.h>
+#include "../parser/complex_eval.h"
 
 double back_diff_derivative(double x, double eps, double (*func)(double)){
     // ((*func)(x) - (*func)(x - eps)) / (x - (x - eps));
@@ -12,4 +13,12 @@ double front_diff_derivative(double x, double eps, double (*func)(double)){
 
 double central_diff_derivative(double x, double eps, double (*func)(double)){
     return ((*func)(x + eps) - (*func)(x - eps)) / (2.0 * eps);
-}
\ No newline at end of file
+}
+
+// f'(x) from one evaluation at x + ih: Im f(x + ih) / h. Nothing is
+// subtracted, so h can be tiny (1e-100 is fine) and there is no step size
+// to tune; f must be real-analytic near x, which everything the parser
+// accepts is wherever it is defined.
+double complex_step_derivative(const Expr *expr, double x, double h){
+    return cimag(expr_eval_complex(expr, CMPLX(x, h))) / h;
+}
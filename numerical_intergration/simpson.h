@@ -2,36 +2,29 @@
 #define INTEG_SIMPSON_H
 
 #include <math.h>
+#include <stddef.h>
 
-double simpson_1_3_integration(double a, double b, const unsigned rects, double (*func)(double)){
-    double h = fabs(b - a)/rects;
-    double res = 0.0;
-    double left = (a < b) ? a : b;
-    for (size_t i = 0; i < rects + 1; i++)
-    {
-        if(i == 0 || i == rects){
-            res += (*func)(left + (i * h));
-        }else if(i % 2 == 0){
-            res += 2 * (*func)(left + (i * h));
-        }else{
-            res += 4 * (*func)(left + (i * h));
-        }
-    }
-    res *= h/3.0;
-    return (res < 0) ? -res : res;
-}
+// One body for every precision, in simpson_typed.h:
+// simpson_1_3_integration() in double, simpson_1_3_integrationf() in float
+// and simpson_1_3_integrationl() in long double, and the same for the 3/8
+// rule. The variant taking a compiled expression is in simpson_batch.h.
+#define TYPED_T double
+#define TYPED_SFX
+#include "simpson_typed.h"
 
+#define TYPED_T float
+#define TYPED_SFX f
+#include "simpson_typed.h"
 
-double simpson_3_8_integration(double a, double b, const unsigned n, double (*func)(double)){
-    double diff = fabs(b - a);
-    if(n == 1){
-        double x1 = a + diff/3.0;
-        double x2 = a + 2 * diff/3.0;
-        double res = diff * ((*func)(a) + 3 * (*func)(x1) + 3 * (*func)(x2) + (*func)(b))/8.0;
-        return (res < 0) ? -res : res;
-    }else{
-        double interval = diff/2;
-        return simpson_3_8_integration(a, a + interval, n-1, func) + simpson_3_8_integration(a + interval, b, n-1, func);
-    }
-}
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "simpson_typed.h"
+
+// pick the precision from the type of a
+#define simpson_1_3_integration_tg(a, b, rects, func) \
+    _Generic((a), float: simpson_1_3_integrationf, long double: simpson_1_3_integrationl, \
+             default: simpson_1_3_integration)(a, b, rects, func)
+#define simpson_3_8_integration_tg(a, b, n, func) \
+    _Generic((a), float: simpson_3_8_integrationf, long double: simpson_3_8_integrationl, \
+             default: simpson_3_8_integration)(a, b, n, func)
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef INTEG_SIMPSON_BATCH_H
+#define INTEG_SIMPSON_BATCH_H
+
+#include <math.h>
+#include "../parser/parser.h"
+
+// Simpson's 1/3 rule over a compiled expression; see simpson_batch_typed.h.
+// simpson_1_3_integration_batch() in double, simpson_1_3_integration_batchf()
+// in float and simpson_1_3_integration_batchl() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "simpson_batch_typed.h"
+
+#define TYPED_T float
+#define TYPED_SFX f
+#include "simpson_batch_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "simpson_batch_typed.h"
+
+// pick the precision from the type of a
+#define simpson_1_3_integration_batch_tg(a, b, rects, func) \
+    _Generic((a), float: simpson_1_3_integration_batchf, long double: simpson_1_3_integration_batchl, \
+             default: simpson_1_3_integration_batch)(a, b, rects, func)
+#endif
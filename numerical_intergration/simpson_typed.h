@@ -0,0 +1,37 @@
+/* Simpson template: the 1/3 and 3/8 rules in every precision; see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(simpson_1_3_integration)(TYPED_T a, TYPED_T b, const unsigned rects, TYPED_T (*func)(TYPED_T)){
+    TYPED_T h = TYPED_NAME(fabs)(b - a)/rects;
+    TYPED_T res = 0.0;
+    TYPED_T left = (a < b) ? a : b;
+    for (size_t i = 0; i < rects + 1; i++)
+    {
+        if(i == 0 || i == rects){
+            res += (*func)(left + (i * h));
+        }else if(i % 2 == 0){
+            res += 2 * (*func)(left + (i * h));
+        }else{
+            res += 4 * (*func)(left + (i * h));
+        }
+    }
+    res *= h/3;
+    return (res < 0) ? -res : res;
+}
+
+TYPED_T TYPED_NAME(simpson_3_8_integration)(TYPED_T a, TYPED_T b, const unsigned n, TYPED_T (*func)(TYPED_T)){
+    TYPED_T diff = TYPED_NAME(fabs)(b - a);
+    if(n == 1){
+        TYPED_T x1 = a + diff/3;
+        TYPED_T x2 = a + 2 * diff/3;
+        TYPED_T res = diff * ((*func)(a) + 3 * (*func)(x1) + 3 * (*func)(x2) + (*func)(b))/8;
+        return (res < 0) ? -res : res;
+    }else{
+        TYPED_T interval = diff/2;
+        return TYPED_NAME(simpson_3_8_integration)(a, a + interval, n-1, func) + TYPED_NAME(simpson_3_8_integration)(a + interval, b, n-1, func);
+    }
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
@@ -1,18 +1,26 @@
 #include <math.h>
 #include <stdio.h>
 
-double trapezoidal_integration(double a, double b, unsigned rects, double (*func)(double)){
-    double width = fabs(b - a) / (double)rects;
-    double result = 0.0;
-    for (size_t i = 1; i <= rects; i++)
-    {
+// One body for every precision, in trapez_typed.h:
+// trapezoidal_integration() in double, trapezoidal_integrationf() in float
+// and trapezoidal_integrationl() in long double. The variant taking a
+// compiled expression is in trapez_batch.h.
+#define TYPED_T double
+#define TYPED_SFX
+#include "trapez_typed.h"
 
-        double h0 = (*func)(a + (width * (double)(i - 1)));
-        double h1 = (*func)(a + (width * (double)(i)));
-        result += 0.5f * width * (h0 + h1);        
-    }
-    return result;
-}
+#define TYPED_T float
+#define TYPED_SFX f
+#include "trapez_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "trapez_typed.h"
+
+// pick the precision from the type of a
+#define trapezoidal_integration_tg(a, b, rects, func) \
+    _Generic((a), float: trapezoidal_integrationf, long double: trapezoidal_integrationl, \
+             default: trapezoidal_integration)(a, b, rects, func)
 
 double trapezoidal_integration_debug(double a, double b, unsigned rects, double (*func)(double)){
     double width = fabs(b - a) / (double)rects;
@@ -0,0 +1,22 @@
+#include <math.h>
+#include "../parser/parser.h"
+
+// The trapezoid rule over a compiled expression; see trapez_batch_typed.h.
+// trapezoidal_integration_batch() in double, trapezoidal_integration_batchf()
+// in float and trapezoidal_integration_batchl() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "trapez_batch_typed.h"
+
+#define TYPED_T float
+#define TYPED_SFX f
+#include "trapez_batch_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "trapez_batch_typed.h"
+
+// pick the precision from the type of a
+#define trapezoidal_integration_batch_tg(a, b, rects, func) \
+    _Generic((a), float: trapezoidal_integration_batchf, long double: trapezoidal_integration_batchl, \
+             default: trapezoidal_integration_batch)(a, b, rects, func)
@@ -0,0 +1,19 @@
+/* Trapezoid template: trapezoidal_integration() in every precision; see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(trapezoidal_integration)(TYPED_T a, TYPED_T b, unsigned rects, TYPED_T (*func)(TYPED_T)){
+    TYPED_T width = TYPED_NAME(fabs)(b - a) / (TYPED_T)rects;
+    TYPED_T result = 0.0;
+    for (size_t i = 1; i <= rects; i++)
+    {
+
+        TYPED_T h0 = (*func)(a + (width * (TYPED_T)(i - 1)));
+        TYPED_T h1 = (*func)(a + (width * (TYPED_T)(i)));
+        result += 0.5f * width * (h0 + h1);
+    }
+    return result;
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
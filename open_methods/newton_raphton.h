@@ -1,5 +1,6 @@
 #include <math.h>
 #include <stdio.h>
+#include "../parser/dual.h"
 // Using the derivative of f(x) we can find the solution
 // By approaching to the answer
 
@@ -7,16 +8,36 @@
 //          x1 = x0 - ( f(x0) / f'(x0) )
 // Return: 
 //          x1 if f(x1) < eps
-double newton_raphton(double x, double eps, double (*func)(double), double (*deriv_func)(double)){
-    double res = (*func)(x);
-    if(fabs(res) <= eps){
-        return x;
-    }
-    do
+//
+// One body for every precision, in newton_raphton_typed.h: newton_raphton()
+// in double, newton_raphtonf() in float and newton_raphtonl() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "newton_raphton_typed.h"
+
+#define TYPED_T float
+#define TYPED_SFX f
+#include "newton_raphton_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "newton_raphton_typed.h"
+
+// picks the precision from the type of x
+#define newton_raphton_tg(x, eps, func, deriv_func) \
+    _Generic((x), float: newton_raphtonf, long double: newton_raphtonl, default: newton_raphton)(x, eps, func, deriv_func)
+
+// Same iteration, but f and f' both come from one dual-number pass over a
+// single compiled expression, so there is no separate f'(x) to write,
+// parse or evaluate.
+double newton_raphton_expr(double x, double eps, const Expr *func){
+    double res, deriv;
+    expr_eval_dual(func, x, &res, &deriv);
+    while (fabs(res) > eps)
     {
-        x = x - res/(*deriv_func)(x);
-        res = (*func)(x);
-    } while (fabs(res) > eps);
+        x = x - res/deriv;
+        expr_eval_dual(func, x, &res, &deriv);
+    }
     return x;
 }
 
@@ -0,0 +1,16 @@
+#include "../parser/ddouble.h"
+
+// Double-double iteration over compiled expressions for f and f' (from
+// expr_derive(), say), for roots where f cancels away the digits double has.
+DDouble newton_raphton_dd(DDouble x, DDouble eps, const Expr *func, const Expr *deriv_func){
+    DDouble res = expr_eval_dd(func, x);
+    if(dd_le(dd_abs(res), eps)){
+        return x;
+    }
+    do
+    {
+        x = dd_sub(x, dd_div(res, expr_eval_dd(deriv_func, x)));
+        res = expr_eval_dd(func, x);
+    } while (dd_lt(eps, dd_abs(res)));
+    return x;
+}
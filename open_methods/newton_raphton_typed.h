@@ -0,0 +1,19 @@
+/* Newton-Raphson template: newton_raphton(), newton_raphtonf() and newton_raphtonl(); see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(newton_raphton)(TYPED_T x, TYPED_T eps, TYPED_T (*func)(TYPED_T), TYPED_T (*deriv_func)(TYPED_T)){
+    TYPED_T res = (*func)(x);
+    if(TYPED_NAME(fabs)(res) <= eps){
+        return x;
+    }
+    do
+    {
+        x = x - res/(*deriv_func)(x);
+        res = (*func)(x);
+    } while (TYPED_NAME(fabs)(res) > eps);
+    return x;
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
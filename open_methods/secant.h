@@ -13,26 +13,23 @@
 // Return: 
 //          x1 if f(x1) < eps
 
-double secant(double x, double eps, double (*func)(double)){
-    double res = (*func)(x);
-    if(fabs(res) <= eps){
-        return x;
-    }
-    
-    double x_old = (x - 1);
-    double res_old = (*func)(x_old);
+// One body for every precision, in secant_typed.h: secant() in double,
+// secantf() in float and secantl() in long double.
+#define TYPED_T double
+#define TYPED_SFX
+#include "secant_typed.h"
 
-    do
-    {
-        double deriv = (res_old - res ) / (x_old - x);
-        x_old = x;
-        res_old = res;
-        x = x - ( res / deriv );
-        res = (*func)(x);
-        
-    } while (fabs(res) > eps);
-    return x;
-}
+#define TYPED_T float
+#define TYPED_SFX f
+#include "secant_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "secant_typed.h"
+
+// picks the precision from the type of x
+#define secant_tg(x, eps, func) \
+    _Generic((x), float: secantf, long double: secantl, default: secant)(x, eps, func)
 
 double secant_debug(double x, double eps, double (*func)(double)){
     static unsigned iterations = 0;
@@ -0,0 +1,23 @@
+#include "../parser/ddouble.h"
+
+// Double-double iteration over a compiled expression; see parser/ddouble.h.
+DDouble secant_dd(DDouble x, DDouble eps, const Expr *func){
+    DDouble res = expr_eval_dd(func, x);
+    if(dd_le(dd_abs(res), eps)){
+        return x;
+    }
+
+    DDouble x_old = dd_sub(x, dd_from(1));
+    DDouble res_old = expr_eval_dd(func, x_old);
+
+    do
+    {
+        DDouble deriv = dd_div(dd_sub(res_old, res), dd_sub(x_old, x));
+        x_old = x;
+        res_old = res;
+        x = dd_sub(x, dd_div(res, deriv));
+        res = expr_eval_dd(func, x);
+
+    } while (dd_lt(eps, dd_abs(res)));
+    return x;
+}
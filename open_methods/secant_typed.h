@@ -0,0 +1,27 @@
+/* Secant template: secant(), secantf() and secantl(); see typed_template.h. */
+
+#include "../typed_template.h"
+
+TYPED_T TYPED_NAME(secant)(TYPED_T x, TYPED_T eps, TYPED_T (*func)(TYPED_T)){
+    TYPED_T res = (*func)(x);
+    if(TYPED_NAME(fabs)(res) <= eps){
+        return x;
+    }
+
+    TYPED_T x_old = (x - 1);
+    TYPED_T res_old = (*func)(x_old);
+
+    do
+    {
+        TYPED_T deriv = (res_old - res ) / (x_old - x);
+        x_old = x;
+        res_old = res;
+        x = x - ( res / deriv );
+        res = (*func)(x);
+
+    } while (TYPED_NAME(fabs)(res) > eps);
+    return x;
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
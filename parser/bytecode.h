@@ -0,0 +1,309 @@
+#ifndef RPN_BYTECODE_H
+#define RPN_BYTECODE_H
+
+/* --- Binary bytecode files ---
+ * expr_save() writes compiled programs to a file that expr_lib_open() maps
+ * read-only and evaluates in place: the Expr handles it returns point their
+ * code and constant pool straight into the mapping, so loading a library
+ * costs one mmap plus a validation pass, nothing is parsed or copied, and
+ * processes mapping the same file share its pages.
+ *
+ * Layout, all offsets from the start of the file so it can be mapped at any
+ * address, in the byte order of the machine that wrote it:
+ *
+ *     ExprFileHeader
+ *     ExprFileEntry[count]       sorted by name for expr_lib_find()
+ *     per program: double consts[nconsts]; Instr code[len];
+ *                  double params[nparams]                    (8-aligned)
+ *     string table: names, variable and parameter names, NUL-terminated
+ *
+ * The opcode numbers are part of the format; changing OpCode means bumping
+ * EXPR_FILE_VERSION. Files of another version or byte order are rejected.
+ *
+ *     const Expr *fs[] = { parse_function("x^2-2"), parse_function("sin(x)") };
+ *     expr_save("models.rpnb", fs, (const char *[]){ "quad", "wave" }, 2);
+ *
+ *     ExprLib *lib = expr_lib_open("models.rpnb");
+ *     double y = expr_eval(expr_lib_find(lib, "wave"), 0.5);
+ *     expr_lib_close(lib);
+ *
+ * Parameter values are saved as they were at expr_save() time. The loaded
+ * values are copied out of the mapping, so expr_set_param() works on library
+ * handles as on any other expression.
+ *
+ * Handles from a library belong to it: never expr_free() them, and stop
+ * using them after expr_lib_close(). */
+
+#include "parser.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define EXPR_FILE_VERSION 2
+#define EXPR_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char     magic[4];         /* "RPNB" */
+    uint32_t version;
+    uint32_t byte_order;       /* EXPR_FILE_BYTE_ORDER as the writer stored it */
+    uint32_t count;
+    uint64_t size;             /* whole file, catches truncation */
+} ExprFileHeader;
+
+typedef struct {
+    uint64_t consts, code;     /* offsets of the constant pool and the program */
+    uint64_t name, vars;       /* offsets of the name and of nvars names in a row */
+    uint64_t params, pnames;   /* offsets of the parameter values and of nparams names */
+    uint32_t len, nconsts, depth, nslots, nvars, nparams;
+} ExprFileEntry;
+
+typedef struct {
+    void  *map;
+    size_t size;
+    int    count;
+    const ExprFileEntry *dir;
+    Expr  *exprs;              /* views into map */
+    char **vars;               /* the exprs' vars and parameter names, pointing into map */
+    ParamTable *params;        /* one per program; values copied out of map */
+    double *values;
+} ExprLib;
+
+/* --- Writing --- */
+typedef struct { char *buf; size_t len, cap; } ByteBuf;
+
+static uint64_t bb_put(ByteBuf *b, const void *src, size_t n, size_t align) {
+    size_t at = (b->len + align - 1) & ~(align - 1);
+    if (at + n > b->cap) {
+        b->cap = (at + n) * 2;
+        b->buf = realloc(b->buf, b->cap);
+    }
+    memset(b->buf + b->len, 0, at - b->len);
+    if (n) memcpy(b->buf + at, src, n);
+    b->len = at + n;
+    return at;
+}
+
+typedef struct { const char *name; int index; } NamedIndex;
+
+static int cmp_by_name(const void *a, const void *b) {
+    return strcmp(((const NamedIndex *)a)->name, ((const NamedIndex *)b)->name);
+}
+
+/* Writes n programs, named names[i] (names may be NULL: then they are only
+ * reachable by index, in the order given). Returns 0, or -1 after printing
+ * why the file could not be written. */
+int expr_save(const char *path, const Expr *const *exprs, const char *const *names, int n) {
+    NamedIndex *order = malloc((n + 1) * sizeof *order);
+    for (int i = 0; i < n; i++) order[i] = (NamedIndex){ names ? names[i] : "", i };
+    if (names) qsort(order, n, sizeof *order, cmp_by_name);
+
+    ByteBuf b = {0}, strs = {0};
+    ExprFileHeader h = { .magic = "RPNB", .version = EXPR_FILE_VERSION,
+                         .byte_order = EXPR_FILE_BYTE_ORDER, .count = n };
+    ExprFileEntry *dir = calloc(n + 1, sizeof *dir);
+    uint64_t *name_at = malloc((n + 1) * sizeof *name_at), *vars_at = malloc((n + 1) * sizeof *vars_at);
+    uint64_t *pnames_at = malloc((n + 1) * sizeof *pnames_at);
+    bb_put(&b, &h, sizeof h, 8);
+    uint64_t dir_at = bb_put(&b, dir, n * sizeof *dir, 8);  // placeholder, filled in below
+
+    for (int k = 0; k < n; k++) {
+        const Expr *e = exprs[order[k].index];
+        int np = e->params ? e->params->n : 0;
+        dir[k] = (ExprFileEntry){ .len = e->len, .nconsts = e->nconsts, .depth = e->depth,
+                                  .nslots = e->nslots, .nvars = e->nvars, .nparams = np };
+        dir[k].consts = bb_put(&b, e->consts, e->nconsts * sizeof *e->consts, 8);
+        dir[k].code = bb_put(&b, e->code, e->len * sizeof *e->code, 8);
+        dir[k].params = bb_put(&b, np ? e->params->values : NULL, np * sizeof(double), 8);
+        name_at[k] = bb_put(&strs, order[k].name, strlen(order[k].name) + 1, 1);
+        vars_at[k] = strs.len;
+        for (int v = 0; v < e->nvars; v++) bb_put(&strs, e->vars[v], strlen(e->vars[v]) + 1, 1);
+        pnames_at[k] = strs.len;
+        for (int v = 0; v < np; v++) bb_put(&strs, e->params->names[v], strlen(e->params->names[v]) + 1, 1);
+    }
+    uint64_t strtab = bb_put(&b, strs.buf, strs.len, 8);
+    for (int k = 0; k < n; k++) {
+        dir[k].name = strtab + name_at[k];
+        dir[k].vars = strtab + vars_at[k];
+        dir[k].pnames = strtab + pnames_at[k];
+    }
+    memcpy(b.buf + dir_at, dir, n * sizeof *dir);
+    h.size = b.len;
+    memcpy(b.buf, &h, sizeof h);
+    free(strs.buf); free(order); free(dir); free(name_at); free(vars_at); free(pnames_at);
+
+    FILE *f = fopen(path, "wb");
+    int ok = f && fwrite(b.buf, 1, b.len, f) == b.len;
+    if (f && fclose(f) != 0) ok = 0;
+    free(b.buf);
+    if (!ok) { fprintf(stderr, "expr_save: cannot write '%s'\n", path); return -1; }
+    return 0;
+}
+
+/* --- Loading --- */
+
+// the file offset range [off, off + n) lies inside the mapping
+static int in_file(const ExprLib *L, uint64_t off, uint64_t n) {
+    return off <= L->size && n <= L->size - off;
+}
+
+static int string_in_file(const ExprLib *L, uint64_t off) {
+    return off < L->size && memchr((const char *)L->map + off, 0, L->size - off) != NULL;
+}
+
+/* Re-checks what parse_function() guarantees: every argument is in range and
+ * the program never over- or underflows the stack depth it declares. The
+ * depth and slot count size the evaluator's stack array, so they must also
+ * be no larger than a program of len instructions can use. */
+static int program_ok(const Expr *e) {
+    if (e->len <= 0 || e->depth <= 0 || e->depth > e->len || e->nslots < 0 || e->nslots > e->len) return 0;
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        Instr in = e->code[i];
+        if (in.op > OP_SQRT) return 0;
+        if (in.op == OP_CONST && in.arg >= (uint32_t)e->nconsts) return 0;
+        if (in.op == OP_VAR && in.arg >= (uint32_t)e->nvars) return 0;
+        if (in.op == OP_PARAM && (e->params == NULL || in.arg >= (uint32_t)e->params->n)) return 0;
+        if ((in.op == OP_LOAD || in.op == OP_STORE) && in.arg >= (uint32_t)e->nslots) return 0;
+        int pops = in.op >= OP_SIN || in.op == OP_DUP || in.op == OP_STORE ? 1 : in.op >= OP_ADD ? 2 : 0;
+        int push = in.op == OP_STORE ? 1 : in.op == OP_DUP ? 2 : 1;
+        if (sp < pops) return 0;
+        sp += push - pops;
+        if (sp > e->depth) return 0;
+    }
+    return sp == 1;
+}
+
+void expr_lib_close(ExprLib *L) {
+    if (L == NULL) return;
+    for (int i = 0; i < L->count; i++) expr_unbind(&L->exprs[i]);
+    munmap(L->map, L->size);
+    free(L->exprs);
+    free(L->vars);
+    free(L->params);
+    free(L->values);
+    free(L);
+}
+
+/* Maps a file written by expr_save(). Returns NULL, after printing why, if
+ * it cannot be read or fails validation. */
+ExprLib *expr_lib_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "expr_lib_open: cannot open '%s'\n", path);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    ExprLib *L = calloc(1, sizeof *L);
+    if (L == NULL) {
+        fprintf(stderr, "expr_lib_open: out of memory for '%s'\n", path);
+        close(fd);
+        return NULL;
+    }
+    L->size = st.st_size;
+    L->map = L->size >= sizeof(ExprFileHeader) ? mmap(NULL, L->size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (L->map == MAP_FAILED) {
+        fprintf(stderr, "expr_lib_open: cannot map '%s'\n", path);
+        free(L);
+        return NULL;
+    }
+
+    const ExprFileHeader *h = L->map;
+    const char *base = L->map;
+    if (memcmp(h->magic, "RPNB", 4) || h->version != EXPR_FILE_VERSION || h->byte_order != EXPR_FILE_BYTE_ORDER
+        || h->size != L->size || !in_file(L, sizeof *h, (uint64_t)h->count * sizeof(ExprFileEntry))) {
+        fprintf(stderr, "expr_lib_open: '%s' is not a version %d bytecode file for this machine\n", path, EXPR_FILE_VERSION);
+        L->count = 0;
+        expr_lib_close(L);
+        return NULL;
+    }
+    const ExprFileEntry *dir = (const ExprFileEntry *)(base + sizeof *h);
+    size_t nvars = 0, nparams = 0;
+    for (uint32_t i = 0; i < h->count; i++) {
+        nvars += dir[i].nvars;
+        nparams += dir[i].nparams;
+    }
+    // every name takes at least its NUL, so bigger counts cannot be genuine
+    if (nvars + nparams > L->size) {
+        fprintf(stderr, "expr_lib_open: '%s' declares more names than it holds\n", path);
+        expr_lib_close(L);
+        return NULL;
+    }
+    L->exprs = calloc(h->count + 1, sizeof *L->exprs);
+    L->vars = malloc((nvars + nparams + 1) * sizeof *L->vars);
+    L->params = calloc(h->count + 1, sizeof *L->params);
+    L->values = malloc((nparams + 1) * sizeof *L->values);
+    if (!L->exprs || !L->vars || !L->params || !L->values) {
+        fprintf(stderr, "expr_lib_open: out of memory for '%s'\n", path);
+        expr_lib_close(L);
+        return NULL;
+    }
+    L->count = h->count;
+    L->dir = dir;
+
+    char **vars = L->vars;
+    double *values = L->values;
+    for (int i = 0; i < L->count; i++) {
+        const ExprFileEntry *d = &L->dir[i];
+        Expr *e = &L->exprs[i];
+        int ok = d->consts % 8 == 0 && d->code % 8 == 0
+              && in_file(L, d->consts, (uint64_t)d->nconsts * sizeof(double))
+              && in_file(L, d->code, (uint64_t)d->len * sizeof(Instr))
+              && d->params % 8 == 0 && in_file(L, d->params, (uint64_t)d->nparams * sizeof(double))
+              && string_in_file(L, d->name);
+        for (uint64_t v = 0, off = d->vars; ok && v < d->nvars; v++) {
+            ok = string_in_file(L, off);
+            if (ok) { vars[v] = (char *)base + off; off += strlen(vars[v]) + 1; }
+        }
+        char **pnames = vars + d->nvars;
+        for (uint64_t v = 0, off = d->pnames; ok && v < d->nparams; v++) {
+            ok = string_in_file(L, off);
+            if (ok) { pnames[v] = (char *)base + off; off += strlen(pnames[v]) + 1; }
+        }
+        if (ok) {
+            *e = (Expr){ .code = (Instr *)(base + d->code), .consts = (double *)(base + d->consts),
+                         .len = d->len, .nconsts = d->nconsts, .depth = d->depth,
+                         .nslots = d->nslots, .nvars = d->nvars, .vars = vars };
+            if (d->nparams) {
+                memcpy(values, base + d->params, d->nparams * sizeof *values);
+                L->params[i] = (ParamTable){ .n = d->nparams, .names = pnames, .values = values };
+                e->params = &L->params[i];
+            }
+            ok = program_ok(e);
+        }
+        if (!ok) {
+            fprintf(stderr, "expr_lib_open: '%s': program %d is corrupt\n", path, i);
+            expr_lib_close(L);
+            return NULL;
+        }
+        vars += d->nvars + d->nparams;
+        values += d->nparams;
+    }
+    return L;
+}
+
+int expr_lib_count(const ExprLib *L) { return L->count; }
+
+// i-th program in name order
+const Expr *expr_lib_get(const ExprLib *L, int i) {
+    return i >= 0 && i < L->count ? &L->exprs[i] : NULL;
+}
+
+const char *expr_lib_name(const ExprLib *L, int i) {
+    return i >= 0 && i < L->count ? (const char *)L->map + L->dir[i].name : NULL;
+}
+
+// binary search over the sorted directory; NULL if there is no such name
+const Expr *expr_lib_find(const ExprLib *L, const char *name) {
+    int lo = 0, hi = L->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2, c = strcmp(expr_lib_name(L, mid), name);
+        if (c == 0) return &L->exprs[mid];
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return NULL;
+}
+
+#endif // RPN_BYTECODE_H
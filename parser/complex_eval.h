@@ -0,0 +1,97 @@
+#ifndef RPN_COMPLEX_EVAL_H
+#define RPN_COMPLEX_EVAL_H
+
+/* --- Complex evaluation ---
+ * expr_eval_complex() runs a compiled program over complex numbers, with
+ * the complex sin, cos, tan, exp, log, sqrt and pow from <complex.h>.
+ * Constants and parameters are real.
+ *
+ * Its main use is the complex step: for f real-analytic near x,
+ * f(x + ih) = f(x) + ih f'(x) + O(h^2), so Im f(x + ih) / h is f'(x) with
+ * no subtraction and therefore no cancellation. h can be as small as 1e-100
+ * and the result is good to machine precision from one evaluation; see
+ * complex_step_derivative() in numerical_differentiation/num_deriv.h.
+ *
+ * Integer powers are computed by repeated squaring rather than cpow(),
+ * which goes through clog() and would lose the tiny imaginary part of a
+ * negative base to the rounding of its argument, close to pi.
+ *
+ * Products and quotients are written out rather than left to the C
+ * operators, which call __muldc3/__divdc3 to recover infinities from NaN
+ * parts (C11 Annex G), a library call per operation for a case finite
+ * operands never hit. Division uses Smith's method, so it does not
+ * overflow where the quotient itself does not. */
+
+#include <complex.h>
+#include "parser.h"
+
+static double complex cmul(double complex z, double complex w) {
+    double a = creal(z), b = cimag(z), c = creal(w), d = cimag(w);
+    return CMPLX(a * c - b * d, a * d + b * c);
+}
+
+static double complex cdiv(double complex z, double complex w) {
+    double a = creal(z), b = cimag(z), c = creal(w), d = cimag(w);
+    if (fabs(c) >= fabs(d)) {
+        double r = d / c, t = c + d * r;
+        return CMPLX((a + b * r) / t, (b - a * r) / t);
+    }
+    double r = c / d, t = c * r + d;
+    return CMPLX((a * r + b) / t, (b * r - a) / t);
+}
+
+static double complex cpow_int(double complex z, long n) {
+    double complex r = 1;
+    for (long k = labs(n); k; k >>= 1) {
+        if (k & 1) r = cmul(r, z);
+        if (k > 1) z = cmul(z, z);
+    }
+    return n < 0 ? cdiv(1, r) : r;
+}
+
+static double complex expr_cpow(double complex z, double complex w) {
+    if (cimag(w) == 0 && creal(w) == trunc(creal(w)) && fabs(creal(w)) <= 1024)
+        return cpow_int(z, (long)creal(w));
+    return cpow(z, w);
+}
+
+// vars holds one value per variable, as for expr_eval_vars()
+double complex expr_eval_complex_vars(const Expr *e, const double complex *vars) {
+    max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+    double complex *stk = expr_scratch(local, sizeof local, (e->depth + e->nslots) * sizeof *stk);
+    if (stk == NULL) return NAN;
+    double complex *slot = stk + e->depth, r;
+    const double *k = e->consts;
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        const Instr *ip = &e->code[i];
+        switch (ip->op) {
+            case OP_CONST: stk[sp++] = k[ip->arg]; break;
+            case OP_VAR:   stk[sp++] = vars[ip->arg]; break;
+            case OP_PARAM: stk[sp++] = e->params->values[ip->arg]; break;
+            case OP_DUP:   stk[sp] = stk[sp - 1]; sp++; break;
+            case OP_LOAD:  stk[sp++] = slot[ip->arg]; break;
+            case OP_STORE: slot[ip->arg] = stk[sp - 1]; break;
+            case OP_ADD:   sp--; stk[sp - 1] = stk[sp - 1] + stk[sp]; break;
+            case OP_SUB:   sp--; stk[sp - 1] = stk[sp - 1] - stk[sp]; break;
+            case OP_MUL:   sp--; stk[sp - 1] = cmul(stk[sp - 1], stk[sp]); break;
+            case OP_DIV:   sp--; stk[sp - 1] = cdiv(stk[sp - 1], stk[sp]); break;
+            case OP_POW:   sp--; stk[sp - 1] = expr_cpow(stk[sp - 1], stk[sp]); break;
+            case OP_SIN:   stk[sp - 1] = csin(stk[sp - 1]); break;
+            case OP_COS:   stk[sp - 1] = ccos(stk[sp - 1]); break;
+            case OP_TAN:   stk[sp - 1] = ctan(stk[sp - 1]); break;
+            case OP_EXP:   stk[sp - 1] = cexp(stk[sp - 1]); break;
+            case OP_LOG:   stk[sp - 1] = clog(stk[sp - 1]); break;
+            case OP_SQRT:  stk[sp - 1] = csqrt(stk[sp - 1]); break;
+        }
+    }
+    r = stk[0];
+    expr_scratch_free(local, stk);
+    return r;
+}
+
+double complex expr_eval_complex(const Expr *e, double complex z) {
+    return expr_eval_complex_vars(e, &z);
+}
+
+#endif // RPN_COMPLEX_EVAL_H
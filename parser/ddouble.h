@@ -0,0 +1,287 @@
+#ifndef RPN_DDOUBLE_H
+#define RPN_DDOUBLE_H
+
+/* --- Double-double arithmetic ---
+ * A DDouble is an unevaluated sum hi + lo of two doubles with |lo| at most
+ * half an ulp of hi, good for about 106 bits (32 digits). + - * / and
+ * sqrt are within a few units of 2^-104 relative; the algorithms are the
+ * ones from Hida, Li and Bailey's QD library, built on the error-free
+ * transforms below. exp, log, sin, cos, tan and pow are accurate to about
+ * 1e-30 relative for arguments of moderate size.
+ *
+ * expr_eval_dd() runs a compiled program in double-double: the cure for
+ * expressions that cancel away every digit double has, such as expanded
+ * polynomials near a multiple root, at a cost of 10-20x double for plain
+ * arithmetic rather than the 1000x of arbitrary precision. Constants stay
+ * the doubles in the Expr, and constant subexpressions were folded in
+ * double when the program was compiled: 1/3 is only as good as double,
+ * x/3 is exact to 106 bits.
+ *
+ * Products use fma() when the target has it (FP_FAST_FMA, e.g. -mfma) and
+ * Dekker's splitting otherwise, which overflows above about 1e300. Values
+ * past the double range come out as inf in hi with a NaN lo and do not
+ * survive further arithmetic. */
+
+#include <math.h>
+#include "parser.h"
+
+typedef struct { double hi, lo; } DDouble;
+
+static inline DDouble dd_from(double a) { return (DDouble){ a, 0 }; }
+static inline double dd_to_double(DDouble a) { return a.hi; }
+
+/* --- Error-free transforms ---
+ * Each returns the rounded result and stores the rounding error in *err,
+ * so result + *err is exact. quick_two_sum() needs |a| >= |b|. */
+static inline double dd_two_sum(double a, double b, double *err) {
+    double s = a + b, bb = s - a;
+    *err = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+static inline double dd_quick_two_sum(double a, double b, double *err) {
+    double s = a + b;
+    *err = b - (s - a);
+    return s;
+}
+
+static inline double dd_two_prod(double a, double b, double *err) {
+    double p = a * b;
+#ifdef FP_FAST_FMA
+    *err = fma(a, b, -p);
+#else
+    const double split = 134217729.0;               // 2^27 + 1
+    double t = split * a, ah = t - (t - a), al = a - ah;
+    t = split * b;
+    double bh = t - (t - b), bl = b - bh;
+    *err = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+    return p;
+}
+
+/* --- Arithmetic --- */
+static inline DDouble dd_neg(DDouble a) { return (DDouble){ -a.hi, -a.lo }; }
+static inline DDouble dd_abs(DDouble a) { return a.hi < 0 ? dd_neg(a) : a; }
+static inline int dd_lt(DDouble a, DDouble b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+static inline int dd_le(DDouble a, DDouble b) { return a.hi < b.hi || (a.hi == b.hi && a.lo <= b.lo); }
+
+static inline DDouble dd_add(DDouble a, DDouble b) {
+    double e, f, s = dd_two_sum(a.hi, b.hi, &e), t = dd_two_sum(a.lo, b.lo, &f);
+    e += t;
+    s = dd_quick_two_sum(s, e, &e);
+    e += f;
+    s = dd_quick_two_sum(s, e, &e);
+    return (DDouble){ s, e };
+}
+
+static inline DDouble dd_sub(DDouble a, DDouble b) { return dd_add(a, dd_neg(b)); }
+
+static inline DDouble dd_mul(DDouble a, DDouble b) {
+    double e, p = dd_two_prod(a.hi, b.hi, &e);
+    e += a.hi * b.lo + a.lo * b.hi;
+    p = dd_quick_two_sum(p, e, &e);
+    return (DDouble){ p, e };
+}
+
+static inline DDouble dd_mul_d(DDouble a, double b) {
+    double e, p = dd_two_prod(a.hi, b, &e);
+    e += a.lo * b;
+    p = dd_quick_two_sum(p, e, &e);
+    return (DDouble){ p, e };
+}
+
+static inline DDouble dd_sqr(DDouble a) {
+    double e, p = dd_two_prod(a.hi, a.hi, &e);
+    e += 2 * a.hi * a.lo + a.lo * a.lo;
+    p = dd_quick_two_sum(p, e, &e);
+    return (DDouble){ p, e };
+}
+
+// three rounds of long division, one double of quotient each
+static inline DDouble dd_div(DDouble a, DDouble b) {
+    double q1 = a.hi / b.hi;
+    DDouble r = dd_sub(a, dd_mul_d(b, q1));
+    double q2 = r.hi / b.hi;
+    r = dd_sub(r, dd_mul_d(b, q2));
+    double q3 = r.hi / b.hi, e;
+    q1 = dd_quick_two_sum(q1, q2, &e);
+    return dd_add((DDouble){ q1, e }, dd_from(q3));
+}
+
+static inline DDouble dd_ldexp(DDouble a, int n) { return (DDouble){ ldexp(a.hi, n), ldexp(a.lo, n) }; }
+
+// exact for a power of two p while nothing overflows or goes subnormal
+static inline DDouble dd_mul_pwr2(DDouble a, double p) { return (DDouble){ a.hi * p, a.lo * p }; }
+
+/* One Newton step from the double square root doubles its precision. The
+ * argument is first scaled by an even power of two to near 1, so that lo
+ * parts of the intermediate products do not go subnormal. */
+static DDouble dd_sqrt(DDouble a) {
+    if (!(a.hi > 0) || isinf(a.hi)) return dd_from(sqrt(a.hi));
+    int k;
+    frexp(a.hi, &k);
+    k &= ~1;
+    a = dd_ldexp(a, -k);
+    double x = 1 / sqrt(a.hi), ax = a.hi * x, e;
+    double s = dd_two_sum(ax, dd_sub(a, dd_sqr(dd_from(ax))).hi * (x * 0.5), &e);
+    return dd_ldexp((DDouble){ s, e }, k / 2);
+}
+
+/* --- Elementary functions --- */
+static const DDouble DD_LN2  = { 6.93147180559945286e-01, 2.31904681384629956e-17 };
+static const double  DD_PIO2[3] = { 1.57079632679489656e+00, 6.12323399573676604e-17, -1.49738490485916983e-33 };
+
+// 1/n! for n = 0..28
+static const DDouble dd_inv_fact[29] = {
+    { 1, 0 }, { 1, 0 }, { 0.5, 0 },
+    { 1.66666666666666657e-01,  9.25185853854297066e-18 }, { 4.16666666666666644e-02,  2.31296463463574266e-18 },
+    { 8.33333333333333322e-03,  1.15648231731787138e-19 }, { 1.38888888888888894e-03, -5.30054395437357706e-20 },
+    { 1.98412698412698413e-04,  1.72095582934207053e-22 }, { 2.48015873015873016e-05,  2.15119478667758816e-23 },
+    { 2.75573192239858925e-06, -1.85839327404647208e-22 }, { 2.75573192239858883e-07,  2.37677146222502973e-23 },
+    { 2.50521083854417202e-08, -1.44881407093591197e-24 }, { 2.08767569878681002e-09, -1.20734505911325997e-25 },
+    { 1.60590438368216133e-10,  1.25852945887520981e-26 }, { 1.14707455977297245e-11,  2.06555127528307454e-28 },
+    { 7.64716373181981641e-13,  7.03872877733453001e-30 }, { 4.77947733238738525e-14,  4.39920548583408126e-31 },
+    { 2.81145725434552060e-15,  1.65088427308614326e-31 }, { 1.56192069685862253e-16,  1.19106796602737540e-32 },
+    { 8.22063524662432950e-18,  2.21418941196042654e-34 }, { 4.11031762331216484e-19,  1.44129733786595271e-36 },
+    { 1.95729410633912626e-20, -1.36435038300879085e-36 }, { 8.89679139245057408e-22, -7.91140261487237622e-38 },
+    { 3.86817017063068413e-23, -8.84317765548234385e-40 }, { 1.61173757109611839e-24, -3.68465735645097660e-41 },
+    { 6.44695028438447359e-26, -1.93304042337034648e-42 }, { 2.47959626322479759e-27, -1.29537309647652288e-43 },
+    { 9.18368986379554601e-29,  1.43031503967873220e-45 }, { 3.27988923706983776e-30,  1.51175427440298787e-46 },
+};
+
+/* x = m ln2 + 512 r, e^r - 1 by Taylor series (|r| < 7e-4, so eight terms
+ * do), then squared back up nine times as s -> 2s + s^2, which keeps the
+ * small quantity e^r - 1 rather than e^r and loses nothing to the 1. */
+static DDouble dd_exp(DDouble a) {
+    if (isnan(a.hi)) return a;
+    if (a.hi > 709.79) return dd_from(INFINITY);
+    if (a.hi < -745.2) return dd_from(0);
+    double m = floor(a.hi / DD_LN2.hi + 0.5);
+    DDouble r = dd_mul_pwr2(dd_sub(a, dd_mul_d(DD_LN2, m)), 0x1p-9), p = r, s = r;
+    for (int n = 2; n <= 9; n++) {
+        p = dd_mul(p, r);
+        s = dd_add(s, dd_mul(p, dd_inv_fact[n]));
+    }
+    for (int i = 0; i < 9; i++) s = dd_add(dd_mul_pwr2(s, 2), dd_sqr(s));
+    return dd_ldexp(dd_add(s, dd_from(1)), (int)m);
+}
+
+/* a = 2^k m with m in [0.5, 1), then one Newton step on exp(y) = m from
+ * the double logarithm; splitting off 2^k keeps exp(-y) in range. */
+static DDouble dd_log(DDouble a) {
+    if (a.hi == 1 && a.lo == 0) return dd_from(0);
+    if (!(a.hi > 0) || isinf(a.hi)) return dd_from(log(a.hi));
+    int k;
+    frexp(a.hi, &k);
+    DDouble m = dd_ldexp(a, -k), x = dd_from(log(m.hi));
+    x = dd_sub(dd_add(x, dd_mul(m, dd_exp(dd_neg(x)))), dd_from(1));
+    return dd_add(dd_mul_d(DD_LN2, k), x);
+}
+
+/* x = n pi/2 + r with pi/2 to 160 bits, so the reduction is good well past
+ * |x| = 1e6. Returns r and stores n mod 4 in *q. */
+static DDouble dd_reduce_pio2(DDouble a, int *q) {
+    double n = nearbyint(a.hi / DD_PIO2[0]), e;
+    double p = dd_two_prod(n, DD_PIO2[0], &e);
+    DDouble r = dd_sub(a, (DDouble){ p, e });
+    p = dd_two_prod(n, DD_PIO2[1], &e);
+    r = dd_sub(r, (DDouble){ p, e });
+    *q = (int)fmod(n, 4) & 3;
+    return dd_sub(r, dd_from(n * DD_PIO2[2]));
+}
+
+// Taylor series of sin (first = 1) or cos (first = 0) over |r| <= pi/4,
+// thirteen terms at most
+static DDouble dd_sin_cos_series(DDouble r, int first) {
+    DDouble r2 = dd_sqr(r), t = first ? r : dd_from(1), sum = t;
+    for (int k = first + 2; k <= 28; k += 2) {
+        t = dd_mul(t, r2);
+        DDouble term = dd_mul(t, dd_inv_fact[k]);
+        sum = (k / 2) % 2 ? dd_sub(sum, term) : dd_add(sum, term);
+        if (fabs(term.hi) < 1e-33) break;
+    }
+    return sum;
+}
+
+static DDouble dd_sin(DDouble a) {
+    if (!isfinite(a.hi)) return dd_from(sin(a.hi));
+    int q;
+    DDouble r = dd_reduce_pio2(a, &q), s = dd_sin_cos_series(r, !(q & 1));
+    return q & 2 ? dd_neg(s) : s;
+}
+
+static DDouble dd_cos(DDouble a) {
+    if (!isfinite(a.hi)) return dd_from(cos(a.hi));
+    int q;
+    DDouble r = dd_reduce_pio2(a, &q), c = dd_sin_cos_series(r, q & 1);
+    return (q + 1) & 2 ? dd_neg(c) : c;
+}
+
+static DDouble dd_tan(DDouble a) {
+    if (!isfinite(a.hi)) return dd_from(tan(a.hi));
+    int q;
+    DDouble r = dd_reduce_pio2(a, &q), s = dd_sin_cos_series(r, 1), c = dd_sin_cos_series(r, 0);
+    return q & 1 ? dd_neg(dd_div(c, s)) : dd_div(s, c);
+}
+
+/* Integer exponents by repeated squaring, the rest through exp and log. A
+ * zero base, and a power too small for a double, take pow()'s value: 0 to
+ * a negative power is +inf, or -inf for -0 to an odd one. */
+static DDouble dd_pow(DDouble a, DDouble b) {
+    if (a.hi == 0) return dd_from(pow(a.hi, b.hi));
+    if (b.lo == 0 && b.hi == trunc(b.hi) && fabs(b.hi) <= 0x1p30) {
+        long n = labs((long)b.hi);
+        DDouble r = dd_from(1), base = a;
+        for (; n; n >>= 1) {
+            if (n & 1) r = dd_mul(r, base);
+            if (n > 1) base = dd_sqr(base);
+        }
+        if (b.hi < 0 && r.hi == 0) return dd_from(pow(a.hi, b.hi));
+        return b.hi < 0 ? dd_div(dd_from(1), r) : r;
+    }
+    if (!(a.hi > 0)) return dd_from(pow(a.hi, b.hi));
+    return dd_exp(dd_mul(b, dd_log(a)));
+}
+
+/* --- Double-double evaluation ---
+ * vars holds one value per variable, as for expr_eval_vars(). */
+DDouble expr_eval_dd_vars(const Expr *e, const DDouble *vars) {
+    max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+    DDouble *stk = expr_scratch(local, sizeof local, (e->depth + e->nslots) * sizeof *stk);
+    if (stk == NULL) return dd_from(NAN);
+    DDouble *slot = stk + e->depth, r;
+    const double *k = e->consts;
+    int sp = 0;
+    stk[0] = dd_from(NAN);      // what an empty program gives; compilers cannot tell there is none
+    for (int i = 0; i < e->len; i++) {
+        const Instr *ip = &e->code[i];
+        switch (ip->op) {
+            case OP_CONST: stk[sp++] = dd_from(k[ip->arg]); break;
+            case OP_VAR:   stk[sp++] = vars[ip->arg]; break;
+            case OP_PARAM: stk[sp++] = dd_from(e->params->values[ip->arg]); break;
+            case OP_DUP:   stk[sp] = stk[sp - 1]; sp++; break;
+            case OP_LOAD:  stk[sp++] = slot[ip->arg]; break;
+            case OP_STORE: slot[ip->arg] = stk[sp - 1]; break;
+            case OP_ADD:   sp--; stk[sp - 1] = dd_add(stk[sp - 1], stk[sp]); break;
+            case OP_SUB:   sp--; stk[sp - 1] = dd_sub(stk[sp - 1], stk[sp]); break;
+            case OP_MUL:   sp--; stk[sp - 1] = dd_mul(stk[sp - 1], stk[sp]); break;
+            case OP_DIV:   sp--; stk[sp - 1] = dd_div(stk[sp - 1], stk[sp]); break;
+            case OP_POW:   sp--; stk[sp - 1] = dd_pow(stk[sp - 1], stk[sp]); break;
+            case OP_SIN:   stk[sp - 1] = dd_sin(stk[sp - 1]); break;
+            case OP_COS:   stk[sp - 1] = dd_cos(stk[sp - 1]); break;
+            case OP_TAN:   stk[sp - 1] = dd_tan(stk[sp - 1]); break;
+            case OP_EXP:   stk[sp - 1] = dd_exp(stk[sp - 1]); break;
+            case OP_LOG:   stk[sp - 1] = dd_log(stk[sp - 1]); break;
+            case OP_SQRT:  stk[sp - 1] = dd_sqrt(stk[sp - 1]); break;
+        }
+    }
+    r = stk[0];
+    expr_scratch_free(local, stk);
+    return r;
+}
+
+DDouble expr_eval_dd(const Expr *e, DDouble x) {
+    return expr_eval_dd_vars(e, &x);
+}
+
+#endif // RPN_DDOUBLE_H
@@ -0,0 +1,69 @@
+#ifndef RPN_DUAL_H
+#define RPN_DUAL_H
+
+/* --- Forward-mode automatic differentiation ---
+ * Runs a compiled program over dual numbers a + a'ε, ε² = 0, seeding x with
+ * derivative 1. One pass yields f(x) and the exact f'(x) (up to rounding),
+ * without a hand-written f' or the two extra evaluations and step-size loss
+ * of a finite difference. The value half performs exactly the operations of
+ * eval_rpn(), so *f matches expr_eval(e, x) bit-for-bit.
+ *
+ * expr_eval_dual_vars() does the same for an expression of several
+ * variables, seeding only variable wrt, which gives the partial derivative. */
+
+#include "parser.h"
+
+void expr_eval_dual_vars(const Expr *e, const double *vars, int wrt, double *f, double *df) {
+    max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+    double *v = expr_scratch(local, sizeof local, 2 * (e->depth + e->nslots) * sizeof *v);
+    if (v == NULL) { *f = *df = NAN; return; }
+    double *d = v + e->depth, *sv = d + e->depth, *sd = sv + e->nslots;
+    const double *k = e->consts;
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        const Instr *ip = &e->code[i];
+        if (ip->op == OP_CONST) { v[sp] = k[ip->arg]; d[sp++] = 0; continue; }
+        if (ip->op == OP_VAR)   { v[sp] = vars[ip->arg]; d[sp++] = ip->arg == (uint32_t)wrt; continue; }
+        if (ip->op == OP_PARAM) { v[sp] = e->params->values[ip->arg]; d[sp++] = 0; continue; }
+        if (ip->op == OP_DUP)   { v[sp] = v[sp - 1]; d[sp] = d[sp - 1]; sp++; continue; }
+        if (ip->op == OP_LOAD)  { v[sp] = sv[ip->arg]; d[sp++] = sd[ip->arg]; continue; }
+        if (ip->op == OP_STORE) { sv[ip->arg] = v[sp - 1]; sd[ip->arg] = d[sp - 1]; continue; }
+        if (ip->op >= OP_SIN) {
+            double a = v[sp - 1], da = d[sp - 1], r;
+            switch (ip->op) {
+                case OP_SIN:  r = sin(a); da *= cos(a); break;
+                case OP_COS:  r = cos(a); da *= -sin(a); break;
+                case OP_TAN:  r = tan(a); da *= 1 + r * r; break;
+                case OP_EXP:  r = exp(a); da *= r; break;
+                case OP_LOG:  r = log(a); da /= a; break;
+                default:      r = sqrt(a); da /= 2 * r; break;
+            }
+            v[sp - 1] = r; d[sp - 1] = da;
+            continue;
+        }
+        sp--;
+        double a = v[sp - 1], da = d[sp - 1], b = v[sp], db = d[sp], r;
+        switch (ip->op) {
+            case OP_ADD: r = a + b; da = da + db; break;
+            case OP_SUB: r = a - b; da = da - db; break;
+            case OP_MUL: r = a * b; da = da * b + a * db; break;
+            case OP_DIV: r = a / b; da = (da - r * db) / b; break;
+            default:
+                r = pow(a, b);
+                // constant exponent keeps negative bases valid: d(a^b) = b a^(b-1) a'
+                if (db == 0) da = da == 0 ? 0 : b * pow(a, b - 1) * da;
+                else da = r * (db * log(a) + (da == 0 ? 0 : b * da / a));
+                break;
+        }
+        v[sp - 1] = r; d[sp - 1] = da;
+    }
+    *f = v[0];
+    *df = d[0];
+    expr_scratch_free(local, v);
+}
+
+void expr_eval_dual(const Expr *e, double x, double *f, double *df) {
+    expr_eval_dual_vars(e, &x, 0, f, df);
+}
+
+#endif // RPN_DUAL_H
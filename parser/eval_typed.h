@@ -0,0 +1,159 @@
+/* Evaluator template: eval_rpn(), expr_eval(), expr_bind() and the rest in every precision; see typed_template.h. */
+
+#include "../typed_template.h"
+
+/* --- Evaluate RPN ---
+ * stk must hold at least e->depth + e->nslots values; the slots live after
+ * the operand stack. vars holds e->nvars values. sp points one past the top.
+ * Constants stay in the Expr as doubles and are converted on use. */
+static TYPED_T TYPED_NAME(eval_rpn)(const Expr *e, TYPED_T *stk, const TYPED_T *vars) {
+    const Instr *ip = e->code, *end = ip + e->len;
+    const double *k = e->consts;
+    TYPED_T *sp = stk, *slot = stk + e->depth;
+    for (; ip < end; ip++) {
+        switch (ip->op) {
+            case OP_CONST: *sp++ = (TYPED_T)k[ip->arg]; break;
+            case OP_VAR:   *sp++ = vars[ip->arg]; break;
+            case OP_PARAM: *sp++ = (TYPED_T)e->params->values[ip->arg]; break;
+            case OP_DUP:   sp[0] = sp[-1]; sp++; break;
+            case OP_LOAD:  *sp++ = slot[ip->arg]; break;
+            case OP_STORE: slot[ip->arg] = sp[-1]; break;
+            case OP_ADD:   sp--; sp[-1] = sp[-1] + sp[0]; break;
+            case OP_SUB:   sp--; sp[-1] = sp[-1] - sp[0]; break;
+            case OP_MUL:   sp--; sp[-1] = sp[-1] * sp[0]; break;
+            case OP_DIV:   sp--; sp[-1] = sp[-1] / sp[0]; break;
+            case OP_POW:   sp--; sp[-1] = TYPED_NAME(pow)(sp[-1], sp[0]); break;
+            case OP_SIN:   sp[-1] = TYPED_NAME(sin)(sp[-1]); break;
+            case OP_COS:   sp[-1] = TYPED_NAME(cos)(sp[-1]); break;
+            case OP_TAN:   sp[-1] = TYPED_NAME(tan)(sp[-1]); break;
+            case OP_EXP:   sp[-1] = TYPED_NAME(exp)(sp[-1]); break;
+            case OP_LOG:   sp[-1] = TYPED_NAME(log)(sp[-1]); break;
+            case OP_SQRT:  sp[-1] = TYPED_NAME(sqrt)(sp[-1]); break;
+        }
+    }
+    return stk[0];
+}
+
+/* expr_eval() and friends taking a single x are for expressions of one
+ * variable, as compiled by parse_function(); expr_eval_vars() takes one
+ * value per variable, in the order given to parse_function_vars(). */
+TYPED_T TYPED_NAME(expr_eval_vars)(const Expr *e, const TYPED_T *vars) {
+    max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+    TYPED_T *stk = expr_scratch(local, sizeof local, (e->depth + e->nslots) * sizeof *stk);
+    if (stk == NULL) return NAN;
+    TYPED_T r = TYPED_NAME(eval_rpn)(e, stk, vars);
+    expr_scratch_free(local, stk);
+    return r;
+}
+
+TYPED_T TYPED_NAME(expr_eval)(const Expr *e, TYPED_T x) {
+    return TYPED_NAME(expr_eval_vars)(e, &x);
+}
+
+/* --- Batched evaluation ---
+ * Runs each instruction across a block of EXPR_BATCH inputs before moving
+ * to the next one. The operand stack is stored structure-of-arrays, one row
+ * of lanes per stack slot, so every opcode is a flat loop the compiler can
+ * vectorize and the program is walked once per block instead of per point.
+ * With EXPR_VMATH defined the function opcodes go to the vmath.h kernels
+ * instead of libm. */
+#define BATCH_BINOP(expr) do { sp--; TYPED_T *restrict a = stk[sp - 1]; const TYPED_T *restrict b = stk[sp]; \
+                                for (size_t j = 0; j < m; j++) a[j] = (expr); } while (0)
+#ifdef EXPR_VMATH
+#define BATCH_UNOP(fn)    TYPED_CAT(vmath_, fn)(stk[sp - 1], stk[sp - 1], m)
+#else
+#define BATCH_UNOP(fn)    do { TYPED_T *restrict a = stk[sp - 1]; for (size_t j = 0; j < m; j++) a[j] = TYPED_NAME(fn)(a[j]); } while (0)
+#endif
+
+/* cols[v] holds the n values of variable v; every y is NaN if the
+ * working storage cannot be allocated */
+void TYPED_NAME(expr_eval_batch_vars)(const Expr *e, const TYPED_T *const *cols, TYPED_T *ys, size_t n) {
+    max_align_t local[EXPR_BATCH_SCRATCH / sizeof(max_align_t)];
+    TYPED_T (*stk)[EXPR_BATCH] = expr_scratch(local, sizeof local, (e->depth + e->nslots) * sizeof *stk);
+    if (stk == NULL) {
+        for (size_t j = 0; j < n; j++) ys[j] = NAN;
+        return;
+    }
+    TYPED_T (*slot)[EXPR_BATCH] = stk + e->depth;
+    const double *k = e->consts;
+    for (size_t base = 0; base < n; base += EXPR_BATCH) {
+        size_t m = n - base < EXPR_BATCH ? n - base : EXPR_BATCH;
+        int sp = 0;
+        for (int i = 0; i < e->len; i++) {
+            const Instr *ip = &e->code[i];
+            switch (ip->op) {
+                case OP_CONST: { TYPED_T c = (TYPED_T)k[ip->arg], *restrict d = stk[sp++]; for (size_t j = 0; j < m; j++) d[j] = c; } break;
+                case OP_VAR:   memcpy(stk[sp++], cols[ip->arg] + base, m * sizeof **stk); break;
+                case OP_PARAM: { TYPED_T c = (TYPED_T)e->params->values[ip->arg], *restrict d = stk[sp++]; for (size_t j = 0; j < m; j++) d[j] = c; } break;
+                case OP_DUP:   memcpy(stk[sp], stk[sp - 1], m * sizeof **stk); sp++; break;
+                case OP_LOAD:  memcpy(stk[sp], slot[ip->arg], m * sizeof **stk); sp++; break;
+                case OP_STORE: memcpy(slot[ip->arg], stk[sp - 1], m * sizeof **stk); break;
+                case OP_ADD:   BATCH_BINOP(a[j] + b[j]); break;
+                case OP_SUB:   BATCH_BINOP(a[j] - b[j]); break;
+                case OP_MUL:   BATCH_BINOP(a[j] * b[j]); break;
+                case OP_DIV:   BATCH_BINOP(a[j] / b[j]); break;
+                case OP_POW:   BATCH_BINOP(TYPED_NAME(pow)(a[j], b[j])); break;
+                case OP_SIN:   BATCH_UNOP(sin); break;
+                case OP_COS:   BATCH_UNOP(cos); break;
+                case OP_TAN:   BATCH_UNOP(tan); break;
+                case OP_EXP:   BATCH_UNOP(exp); break;
+                case OP_LOG:   BATCH_UNOP(log); break;
+                case OP_SQRT:  BATCH_UNOP(sqrt); break;
+            }
+        }
+        memcpy(ys + base, stk[0], m * sizeof *ys);
+    }
+    expr_scratch_free(local, stk);
+}
+
+#undef BATCH_BINOP
+#undef BATCH_UNOP
+
+void TYPED_NAME(expr_eval_batch)(const Expr *e, const TYPED_T *xs, TYPED_T *ys, size_t n) {
+    TYPED_NAME(expr_eval_batch_vars)(e, &xs, ys, n);
+}
+
+/* --- Binding to a plain function pointer ---
+ * The solvers take a bare function pointer, which cannot carry the Expr with
+ * it. The process has a small pool of trampolines; expr_bind() parks the
+ * expression in a free slot and hands out that slot's trampoline. Slots are
+ * shared by all threads, so freeing the expression on any thread releases
+ * its slot. expr_bind() returns NULL when every slot is taken, and callers
+ * must check for that before passing the result on. */
+static _Atomic(const Expr *) TYPED_NAME(bound)[EXPR_BIND_SLOTS];
+
+#define EXPR_TRAMPOLINE(i) \
+    static TYPED_T TYPED_NAME(_eval##i)(TYPED_T x) { return TYPED_NAME(expr_eval)(atomic_load_explicit(&TYPED_NAME(bound)[i], memory_order_acquire), x); }
+EXPR_TRAMPOLINE(0) EXPR_TRAMPOLINE(1) EXPR_TRAMPOLINE(2) EXPR_TRAMPOLINE(3)
+EXPR_TRAMPOLINE(4) EXPR_TRAMPOLINE(5) EXPR_TRAMPOLINE(6) EXPR_TRAMPOLINE(7)
+#undef EXPR_TRAMPOLINE
+
+static TYPED_T (*const TYPED_NAME(trampolines)[EXPR_BIND_SLOTS])(TYPED_T) = {
+    TYPED_NAME(_eval0), TYPED_NAME(_eval1), TYPED_NAME(_eval2), TYPED_NAME(_eval3),
+    TYPED_NAME(_eval4), TYPED_NAME(_eval5), TYPED_NAME(_eval6), TYPED_NAME(_eval7)
+};
+
+// NULL if e has more than one variable or all slots are in use
+TYPED_T (*TYPED_NAME(expr_bind)(const Expr *e))(TYPED_T) {
+    if (e->nvars > 1) { fprintf(stderr, "expr_bind: expression has %d variables\n", e->nvars); return NULL; }
+    for (int i = 0; i < EXPR_BIND_SLOTS; i++)
+        if (atomic_load(&TYPED_NAME(bound)[i]) == e) return TYPED_NAME(trampolines)[i];
+    for (int i = 0; i < EXPR_BIND_SLOTS; i++) {
+        const Expr *free_slot = NULL;
+        if (atomic_compare_exchange_strong(&TYPED_NAME(bound)[i], &free_slot, e)) return TYPED_NAME(trampolines)[i];
+        if (free_slot == e) return TYPED_NAME(trampolines)[i];     // another thread bound it meanwhile
+    }
+    fprintf(stderr, "expr_bind: all %d slots in use\n", EXPR_BIND_SLOTS);
+    return NULL;
+}
+
+static void TYPED_NAME(unbind_pool)(const Expr *e) {
+    for (int i = 0; i < EXPR_BIND_SLOTS; i++) {
+        const Expr *mine = e;
+        atomic_compare_exchange_strong(&TYPED_NAME(bound)[i], &mine, NULL);
+    }
+}
+
+#undef TYPED_T
+#undef TYPED_SFX
+#undef EXPR_VMATH
@@ -0,0 +1,199 @@
+#ifndef RPN_INTERVAL_H
+#define RPN_INTERVAL_H
+
+/* --- Interval evaluation ---
+ * expr_eval_interval() runs a compiled program over closed intervals and
+ * returns an enclosure: for every x in [lo, hi] where f is defined, f(x)
+ * lies in the result. Every computed bound is pushed one ulp outward with
+ * nextafter(), which covers the rounding of + - * / (correctly rounded) and
+ * of the libm calls (glibc keeps them within one ulp).
+ *
+ * Where f is defined nowhere on the input, e.g. log over [-2, -1], the
+ * result is empty, represented by NaN bounds. Where it is undefined on part
+ * of it only, the enclosure covers the rest and says nothing about the gap;
+ * expr_eval_interval_def() also reports whether f is certainly defined and
+ * finite on the whole box, which callers reasoning about continuity, such as
+ * a monotonicity test, need. Subexpressions the optimiser
+ * turned into x dup * are recognised as squares, so x^2 over [-1, 2] gives
+ * [0, 4] rather than [-2, 4]. */
+
+#include "parser.h"
+
+typedef struct { double lo, hi; } Interval;
+
+#define IV_EMPTY  ((Interval){ NAN, NAN })
+#define IV_ENTIRE ((Interval){ -INFINITY, INFINITY })
+
+static int iv_empty(Interval a) { return isnan(a.lo); }
+static double down(double v) { return nextafter(v, -INFINITY); }
+static double up(double v)   { return nextafter(v, INFINITY); }
+
+// [lo, hi] widened outward; a NaN bound means the hull is unknown, not empty
+static Interval iv_round(double lo, double hi) {
+    if (isnan(lo) || isnan(hi)) return IV_ENTIRE;
+    return (Interval){ down(lo), up(hi) };
+}
+
+static Interval iv_hull4(double a, double b, double c, double d) {
+    if (isnan(a) || isnan(b) || isnan(c) || isnan(d)) return IV_ENTIRE;
+    return iv_round(fmin(fmin(a, b), fmin(c, d)), fmax(fmax(a, b), fmax(c, d)));
+}
+
+static Interval iv_mul(Interval a, Interval b) {
+    return iv_hull4(a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi);
+}
+
+static Interval iv_sqr(Interval a) {
+    double l = a.lo * a.lo, h = a.hi * a.hi;
+    if (a.lo <= 0 && a.hi >= 0) return (Interval){ 0, up(fmax(l, h)) };
+    return iv_round(fmin(l, h), fmax(l, h));
+}
+
+static Interval iv_div(Interval a, Interval b) {
+    if (b.lo == 0 && b.hi == 0) return IV_EMPTY;
+    if (b.lo <= 0 && b.hi >= 0) return IV_ENTIRE;
+    return iv_hull4(a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi);
+}
+
+static Interval iv_pow(Interval a, Interval b) {
+    if (b.lo == b.hi && b.lo == trunc(b.lo) && fabs(b.lo) < 0x1p53) {
+        double n = b.lo;
+        if (n == 0) return (Interval){ 1, 1 };
+        if (n < 0) return iv_div((Interval){ 1, 1 }, iv_pow(a, (Interval){ -n, -n }));
+        double l = pow(a.lo, n), h = pow(a.hi, n);
+        if (fmod(n, 2) != 0) return iv_round(l, h);                     // odd: increasing
+        if (a.lo <= 0 && a.hi >= 0) return (Interval){ 0, up(fmax(l, h)) };
+        return iv_round(fmin(l, h), fmax(l, h));
+    }
+    // real exponents: pow is only defined for a >= 0, where it is monotone in
+    // each argument, so the extremes are at the corners
+    if (a.hi < 0) return b.lo == b.hi ? IV_EMPTY : IV_ENTIRE;        // only integer b hit values
+    if (a.lo < 0) {
+        if (b.lo != b.hi) return IV_ENTIRE;
+        a.lo = 0;
+    }
+    Interval r = iv_hull4(pow(a.lo, b.lo), pow(a.lo, b.hi), pow(a.hi, b.lo), pow(a.hi, b.hi));
+    if (r.lo < 0) r.lo = 0;
+    return r;
+}
+
+// true if peak + 2πk lies in [lo, hi] for some integer k, erring towards yes
+static int has_phase(double lo, double hi, double peak) {
+    double k = ceil((lo - peak) / (2 * M_PI)), p = peak + 2 * M_PI * k;
+    double slack = 4 * (fabs(lo) + fabs(hi) + 1) * 0x1p-52;
+    return p - slack <= hi || p - 2 * M_PI + slack >= lo;
+}
+
+// sin (shift 0) or cos (shift π/2): maxima at π/2 - shift + 2πk, minima π later
+static Interval iv_sincos(Interval a, double (*fn)(double), double shift) {
+    if (!isfinite(a.lo) || !isfinite(a.hi) || a.hi - a.lo >= 2 * M_PI) return (Interval){ -1, 1 };
+    double l = fn(a.lo), h = fn(a.hi);
+    Interval r = iv_round(fmin(l, h), fmax(l, h));
+    if (has_phase(a.lo, a.hi, M_PI / 2 - shift)) r.hi = 1;
+    if (has_phase(a.lo, a.hi, -M_PI / 2 - shift)) r.lo = -1;
+    return (Interval){ fmax(r.lo, -1), fmin(r.hi, 1) };
+}
+
+static Interval iv_tan(Interval a) {
+    if (!isfinite(a.lo) || !isfinite(a.hi) || a.hi - a.lo >= M_PI) return IV_ENTIRE;
+    // poles at π/2 + πk, i.e. where cos changes sign; tan is increasing between
+    if (has_phase(a.lo, a.hi, M_PI / 2) || has_phase(a.lo, a.hi, -M_PI / 2)) return IV_ENTIRE;
+    return iv_round(tan(a.lo), tan(a.hi));
+}
+
+static Interval iv_unary(OpCode op, Interval a) {
+    switch (op) {
+        case OP_SIN: return iv_sincos(a, sin, 0);
+        case OP_COS: return iv_sincos(a, cos, M_PI / 2);
+        case OP_TAN: return iv_tan(a);
+        case OP_EXP: {
+            Interval r = iv_round(exp(a.lo), exp(a.hi));
+            return (Interval){ fmax(r.lo, 0), r.hi };
+        }
+        case OP_LOG:
+            if (a.hi <= 0) return a.hi == 0 ? (Interval){ -INFINITY, -INFINITY } : IV_EMPTY;
+            return (Interval){ a.lo <= 0 ? -INFINITY : down(log(a.lo)), up(log(a.hi)) };
+        default:
+            if (a.hi < 0) return IV_EMPTY;
+            return (Interval){ a.lo <= 0 ? 0 : down(sqrt(a.lo)), up(sqrt(a.hi)) };
+    }
+}
+
+// true if op is defined at every point of a (and b), with a finite value
+static int iv_defined(OpCode op, Interval a, Interval b, Interval r) {
+    if (iv_empty(r) || !isfinite(r.lo) || !isfinite(r.hi)) return 0;
+    switch (op) {
+        case OP_LOG:  return a.lo > 0;
+        case OP_SQRT: return a.lo >= 0;
+        case OP_POW:  return a.lo > 0 || (b.lo == b.hi && b.lo == trunc(b.lo) && (b.lo >= 0 || a.hi < 0));
+        default:      return 1;     // division by an interval holding 0, and tan's poles, give infinite bounds
+    }
+}
+
+/* vars holds one interval per variable. An operand computed from an empty
+ * interval makes the whole result empty: f is undefined everywhere there.
+ * If defined is not NULL it is cleared unless every operation was defined
+ * and finite over all of its operands. */
+static Interval iv_eval(const Expr *e, const Interval *vars, int *defined) {
+    max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+    Interval *stk = expr_scratch(local, sizeof local, (e->depth + e->nslots) * sizeof *stk);
+    if (stk == NULL) {
+        if (defined) *defined = 0;
+        return IV_ENTIRE;
+    }
+    Interval *slot = stk + e->depth, r;
+    const double *k = e->consts;
+    int sp = 0, dup = 0;      // dup: the top two entries are the same value
+    for (int i = 0; i < e->len; i++) {
+        const Instr *ip = &e->code[i];
+        int was_dup = dup;
+        dup = 0;
+        switch (ip->op) {
+            case OP_CONST: stk[sp++] = (Interval){ k[ip->arg], k[ip->arg] }; continue;
+            case OP_VAR:   stk[sp++] = vars[ip->arg]; continue;
+            case OP_PARAM: { double v = e->params->values[ip->arg]; stk[sp++] = (Interval){ v, v }; } continue;
+            case OP_DUP:   stk[sp] = stk[sp - 1]; sp++; dup = 1; continue;
+            case OP_LOAD:  stk[sp++] = slot[ip->arg]; continue;
+            case OP_STORE: slot[ip->arg] = stk[sp - 1]; dup = was_dup; continue;
+            default: break;
+        }
+        if (ip->op >= OP_SIN) {
+            Interval a = stk[sp - 1];
+            if (!iv_empty(a)) stk[sp - 1] = iv_unary(ip->op, a);
+            if (defined && !iv_defined(ip->op, a, a, stk[sp - 1])) *defined = 0;
+            continue;
+        }
+        sp--;
+        Interval a = stk[sp - 1], b = stk[sp];
+        if (iv_empty(a) || iv_empty(b)) { stk[sp - 1] = IV_EMPTY; if (defined) *defined = 0; continue; }
+        switch (ip->op) {
+            case OP_ADD: r = iv_round(a.lo + b.lo, a.hi + b.hi); break;
+            case OP_SUB: r = iv_round(a.lo - b.hi, a.hi - b.lo); break;
+            case OP_MUL: r = was_dup ? iv_sqr(a) : iv_mul(a, b); break;
+            case OP_DIV: r = iv_div(a, b); break;
+            default:     r = iv_pow(a, b); break;
+        }
+        stk[sp - 1] = r;
+        if (defined && !iv_defined(ip->op, a, b, r)) *defined = 0;
+    }
+    if (defined && iv_empty(stk[0])) *defined = 0;
+    r = stk[0];
+    expr_scratch_free(local, stk);
+    return r;
+}
+
+Interval expr_eval_interval_vars(const Expr *e, const Interval *vars) {
+    return iv_eval(e, vars, NULL);
+}
+
+Interval expr_eval_interval(const Expr *e, Interval x) {
+    return iv_eval(e, &x, NULL);
+}
+
+// same, and *defined = 1 only if f is certainly defined and finite at every x in the box
+Interval expr_eval_interval_def(const Expr *e, Interval x, int *defined) {
+    *defined = 1;
+    return iv_eval(e, &x, defined);
+}
+
+#endif // RPN_INTERVAL_H
@@ -0,0 +1,168 @@
+#ifndef RPN_JIT_H
+#define RPN_JIT_H
+
+/* --- Native x86-64 backend for compiled expressions ---
+ * expr_jit() translates an Expr into SSE2 machine code in an mmap'd buffer
+ * and returns a real double(*)(double) that can be handed straight to
+ * bisection_meth(), newton_raphton(), simpson_1_3_integration() and the rest.
+ * The generated code performs the same IEEE operations in the same order as
+ * eval_rpn() and calls the same libm functions, so results are bit-identical.
+ *
+ * On anything other than x86-64 with anonymous mmap, and for expressions of
+ * more than one variable, expr_jit() returns NULL and callers fall back to
+ * the interpreter:
+ *
+ *     double (*f)(double) = expr_jit(e);
+ *     if (f == NULL) f = expr_bind(e);
+ *
+ * Layout: the top of the operand stack is kept in xmm0, everything below it
+ * lives in rbp-relative frame slots, x is saved in the slot after the last
+ * one and the CSE slots follow x. Constants are copied behind the code and
+ * loaded RIP-relative. Parameters are loaded from the expression's table by
+ * absolute address on every call, so rebinding one needs no recompile; the
+ * function references nothing else of the Expr, but must not outlive it when
+ * the text has $parameters. */
+
+#include "parser.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) && !defined(_WIN32) && defined(MAP_ANONYMOUS)
+#define EXPR_HAVE_JIT 1
+
+typedef struct { unsigned char *buf; size_t len, cap; } JitBuf;
+
+static void jb_bytes(JitBuf *b, const void *src, size_t n) {
+    if (b->len + n > b->cap) b->buf = realloc(b->buf, b->cap = (b->cap + n) * 2);
+    memcpy(b->buf + b->len, src, n);
+    b->len += n;
+}
+#define JB(b, ...) do { static const unsigned char _op[] = { __VA_ARGS__ }; jb_bytes((b), _op, sizeof _op); } while (0)
+static void jb_u32(JitBuf *b, uint32_t v) { jb_bytes(b, &v, 4); }
+static void jb_u64(JitBuf *b, uint64_t v) { jb_bytes(b, &v, 8); }
+
+// disp32 of operand-stack position i (0 = bottom) relative to rbp
+static uint32_t jit_slot(int i) { return (uint32_t)(-8 * (i + 1)); }
+
+static void jit_store_tos(JitBuf *b, int i) { JB(b, 0xF2, 0x0F, 0x11, 0x85); jb_u32(b, jit_slot(i)); } // movsd [rbp+d], xmm0
+static void jit_load_tos(JitBuf *b, int i)  { JB(b, 0xF2, 0x0F, 0x10, 0x85); jb_u32(b, jit_slot(i)); } // movsd xmm0, [rbp+d]
+
+static void jit_call(JitBuf *b, uintptr_t fn) {
+    JB(b, 0x48, 0xB8); jb_u64(b, fn);                         // mov rax, imm64
+    JB(b, 0xFF, 0xD0);                                        // call rax
+}
+
+double (*expr_jit(const Expr *e))(double) {
+    if (e->nvars > 1) return NULL;
+    JitBuf b = {0};
+    int nfix = 0, *fix_at = malloc((e->len + 1) * sizeof *fix_at), *fix_k = malloc((e->len + 1) * sizeof *fix_k);
+    int xslot = e->depth;
+    uint32_t frame = (8 * (e->depth + 1 + e->nslots) + 15) & ~15u;
+
+    // header: mapping size, patched below; the function starts 16 bytes in
+    jb_u64(&b, 0); jb_u64(&b, 0);
+    JB(&b, 0x55);                                   // push rbp
+    JB(&b, 0x48, 0x89, 0xE5);                       // mov rbp, rsp
+    JB(&b, 0x48, 0x81, 0xEC); jb_u32(&b, frame);    // sub rsp, frame
+    jit_store_tos(&b, xslot);                       // spill x
+
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        const Instr *in = &e->code[i];
+        switch (in->op) {
+            case OP_CONST:
+                if (sp > 0) jit_store_tos(&b, sp - 1);
+                JB(&b, 0xF2, 0x0F, 0x10, 0x05);         // movsd xmm0, [rip+d]
+                fix_at[nfix] = b.len; fix_k[nfix++] = in->arg;
+                jb_u32(&b, 0);
+                sp++;
+                break;
+            case OP_VAR:
+                if (sp > 0) jit_store_tos(&b, sp - 1);
+                jit_load_tos(&b, xslot);
+                sp++;
+                break;
+            case OP_PARAM:
+                if (sp > 0) jit_store_tos(&b, sp - 1);
+                JB(&b, 0x48, 0xB8); jb_u64(&b, (uintptr_t)&e->params->values[in->arg]);  // mov rax, imm64
+                JB(&b, 0xF2, 0x0F, 0x10, 0x00);         // movsd xmm0, [rax]
+                sp++;
+                break;
+            case OP_DUP:
+                jit_store_tos(&b, sp - 1);
+                sp++;
+                break;
+            case OP_LOAD:
+                if (sp > 0) jit_store_tos(&b, sp - 1);
+                jit_load_tos(&b, xslot + 1 + in->arg);
+                sp++;
+                break;
+            case OP_STORE:
+                jit_store_tos(&b, xslot + 1 + in->arg);
+                break;
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_POW:
+                sp--;
+                JB(&b, 0x66, 0x0F, 0x28, 0xC8);         // movapd xmm1, xmm0
+                jit_load_tos(&b, sp - 1);               // xmm0 = a
+                switch (in->op) {
+                    case OP_ADD: JB(&b, 0xF2, 0x0F, 0x58, 0xC1); break;  // addsd xmm0, xmm1
+                    case OP_SUB: JB(&b, 0xF2, 0x0F, 0x5C, 0xC1); break;  // subsd
+                    case OP_MUL: JB(&b, 0xF2, 0x0F, 0x59, 0xC1); break;  // mulsd
+                    case OP_DIV: JB(&b, 0xF2, 0x0F, 0x5E, 0xC1); break;  // divsd
+                    default:     jit_call(&b, (uintptr_t)pow); break;
+                }
+                break;
+            case OP_SQRT: JB(&b, 0xF2, 0x0F, 0x51, 0xC0); break;          // sqrtsd xmm0, xmm0
+            case OP_SIN:  jit_call(&b, (uintptr_t)sin); break;
+            case OP_COS:  jit_call(&b, (uintptr_t)cos); break;
+            case OP_TAN:  jit_call(&b, (uintptr_t)tan); break;
+            case OP_EXP:  jit_call(&b, (uintptr_t)exp); break;
+            case OP_LOG:  jit_call(&b, (uintptr_t)log); break;
+            default:
+                free(b.buf); free(fix_at); free(fix_k);
+                return NULL;
+        }
+    }
+    JB(&b, 0xC9, 0xC3);                             // leave; ret
+
+    // constant pool, 8-byte aligned, and the rip-relative fixups into it
+    while (b.len % 8) JB(&b, 0xCC);
+    size_t pool = b.len;
+    jb_bytes(&b, e->consts, e->nconsts * sizeof *e->consts);
+    for (int i = 0; i < nfix; i++) {
+        int32_t d = (int32_t)(pool + 8 * fix_k[i] - (fix_at[i] + 4));
+        memcpy(b.buf + fix_at[i], &d, 4);
+    }
+    free(fix_at); free(fix_k);
+
+    size_t size = b.len;
+    memcpy(b.buf, &size, sizeof size);
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) { free(b.buf); return NULL; }
+    memcpy(mem, b.buf, size);
+    free(b.buf);
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) { munmap(mem, size); return NULL; }
+    return (double (*)(double))((char *)mem + 16);
+}
+
+void expr_jit_free(double (*f)(double)) {
+    if (f == NULL) return;
+    char *base = (char *)f - 16;
+    size_t size;
+    memcpy(&size, base, sizeof size);
+    munmap(base, size);
+}
+
+#undef JB
+
+#else
+#define EXPR_HAVE_JIT 0
+
+double (*expr_jit(const Expr *e))(double) { (void)e; return NULL; }
+void expr_jit_free(double (*f)(double)) { (void)f; }
+
+#endif
+
+#endif // RPN_JIT_H
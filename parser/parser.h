@@ -1,8 +1,15 @@
+#ifndef RPN_PARSER_H
+#define RPN_PARSER_H
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #ifndef M_E
 #define M_E 2.71828182845904523536
@@ -10,20 +17,106 @@
 
 /* --- Data structures for tokens & RPN --- */
 typedef enum {
-    T_NUMBER, T_VAR,
+    T_NUMBER, T_VAR, T_PARAM,
     T_PLUS, T_MINUS, T_MUL, T_DIV, T_POW,
     T_LPAREN, T_RPAREN,
     T_FUNC
 } TokenType;
 
+/* Opcodes of the compiled program. Function names are resolved to one of
+ * these by the tokenizer, so evaluation never looks at a string. */
+typedef enum {
+    OP_CONST, OP_VAR, OP_PARAM, OP_DUP, OP_LOAD, OP_STORE,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW,
+    OP_SIN, OP_COS, OP_TAN, OP_EXP, OP_LOG, OP_SQRT
+} OpCode;
+
 typedef struct {
     TokenType type;
-    double   value;
-    char     func[8];
+    OpCode    op;       /* operator/function this token compiles to */
+    double    value;
+    uint32_t  var;      /* T_VAR: index of the variable, T_PARAM: of the parameter */
 } Token;
 
-static Token *rpn = NULL;
-static int    rpn_len = 0;
+/* One instruction is 8 bytes: the opcode and, for OP_CONST, an index into
+ * the expression's constant pool, for OP_VAR a variable index, for OP_PARAM
+ * a parameter index, for OP_LOAD/OP_STORE a slot index. */
+typedef struct {
+    uint32_t op;
+    uint32_t arg;
+} Instr;
+
+/* Values of the $names in an expression's text, such as $a in
+ * "$a*sin(x) - $b*x". The program reads them on every evaluation, so
+ * expr_set_param() rebinds one with a single store: no re-parse, no
+ * re-compile. Derivatives taken with expr_derive() share the table of the
+ * expression they came from and follow its values. */
+typedef struct {
+    int     n;
+    char  **names;     /* without the '$', indexed like OP_PARAM's arg */
+    double *values;    /* start out 0 */
+    _Atomic int refs;  /* owners besides the first */
+} ParamTable;
+
+/* A compiled expression owns its program and is never modified after
+ * parse_function() returns, so any number of them can be alive at once and
+ * several threads may evaluate the same one concurrently. Only the reference
+ * count changes, when the expression cache hands the same one out again, and
+ * the parameter values, which live behind a pointer and are the caller's to
+ * synchronise with any evaluation running at the same time. */
+typedef struct sExpr {
+    Instr  *code;
+    double *consts;
+    int     len;
+    int     cap;     /* instructions code has room for; len can drop below it when folding */
+    int     nconsts;
+    int    *cindex;  /* while compiling: hash index of consts for add_const(), entry index + 1 */
+    int     ccap;    /* slots in cindex, a power of two */
+    int     depth;   /* operand-stack slots eval needs, fixed at compile time */
+    int     nslots;  /* common subexpression slots, stored after the stack */
+    int     nvars;   /* length of the vars array eval takes */
+    char  **vars;    /* variable names, indexed like OP_VAR's arg */
+    ParamTable *params; /* NULL when the text has no $names */
+    _Atomic int refs; /* owners besides the first; expr_free() frees at 0 */
+    const struct sExpr *base; /* program a cache handle shares, NULL if e owns its own */
+} Expr;
+
+/* --- Working storage ---
+ * Operand stacks and other buffers sized by the expression grow with the
+ * text the user typed, so they never go on the C stack as variable-length
+ * arrays. A function keeps a fixed local buffer and takes anything bigger
+ * from the heap:
+ *
+ *     max_align_t local[EXPR_SCRATCH / sizeof(max_align_t)];
+ *     double *stk = expr_scratch(local, sizeof local, n * sizeof *stk);
+ *     ...
+ *     expr_scratch_free(local, stk);
+ *
+ * NULL means the heap allocation failed. */
+#define EXPR_SCRATCH 2048
+
+static void *expr_scratch(void *local, size_t cap, size_t bytes) { return bytes <= cap ? local : malloc(bytes); }
+static void expr_scratch_free(void *local, void *p) { if (p != local) free(p); }
+
+static const struct { const char *name; OpCode op; } func_table[] = {
+    { "sin", OP_SIN }, { "cos", OP_COS }, { "tan", OP_TAN },
+    { "exp", OP_EXP }, { "log", OP_LOG }, { "sqrt", OP_SQRT },
+};
+
+static const char *op_name(OpCode op) {
+    static const char *binops[] = { "+", "-", "*", "/", "^" };
+    if (op >= OP_ADD && op <= OP_POW) return binops[op - OP_ADD];
+    for (size_t i = 0; i < sizeof func_table / sizeof *func_table; i++)
+        if (func_table[i].op == op) return func_table[i].name;
+    switch (op) {
+        case OP_VAR:   return "x";
+        case OP_PARAM: return "param";
+        case OP_DUP:   return "dup";
+        case OP_LOAD:  return "load";
+        case OP_STORE: return "store";
+        default:       return "const";
+    }
+}
 
 /* --- Stack for tokens --- */
 typedef struct { Token *data; int top, cap; } TStack;
@@ -45,14 +138,28 @@ static int prec(TokenType t) {
 }
 static int is_right_assoc(TokenType t) { return t == T_POW; }
 
-/* --- Tokenizer --- */
-static Token *tokenize(const char *s, int *ntok) {
+// index of parameter name[0..len) in p, which gets it appended if it is new
+static int param_intern(ParamTable *p, const char *name, size_t len) {
+    int i = 0;
+    while (i < p->n && (strlen(p->names[i]) != len || strncmp(p->names[i], name, len))) i++;
+    if (i < p->n) return i;
+    p->names = realloc(p->names, (p->n + 1) * sizeof *p->names);
+    p->names[p->n] = strndup(name, len);
+    return p->n++;
+}
+
+/* --- Tokenizer ---
+ * Identifiers are [A-Za-z_][A-Za-z0-9_]*. Each one is a function name, one
+ * of the nvars variable names (compiled to its index, so evaluation never
+ * sees a name) or the constant e, checked in that order. An identifier
+ * right after a '$' is a parameter; its name is added to params. */
+static Token *tokenize(const char *s, int *ntok, const char *const *vars, int nvars, ParamTable *params) {
     Token *out = NULL; int cap = 0, n = 0;
     TokenType last = T_LPAREN;
 
     #define EMIT(tok) do {                 \
         if (n == cap)                     \
-            out = realloc(out, (cap ? cap*2 : 64) * sizeof *out); \
+            out = realloc(out, (cap = cap ? cap*2 : 64) * sizeof *out); \
         out[n] = (tok);                   \
         last = out[n].type;               \
         n++;                              \
@@ -72,31 +179,40 @@ static Token *tokenize(const char *s, int *ntok) {
             i = end - s;
             continue;
         }
-        // variable or constant
-        if (s[i] == 'x' || s[i] == 'e') {
-            Token t = { .type = s[i] == 'x' ? T_VAR : T_NUMBER, .value = s[i] == 'e' ? M_E : 0 };
+        // parameter
+        if (s[i] == '$') {
+            int start = ++i;
+            while (isalnum((unsigned char)s[i]) || s[i] == '_') i++;
+            if (i == start || isdigit((unsigned char)s[start])) { fprintf(stderr, "Expected a parameter name after '$'\n"); exit(1); }
+            Token t = { .type = T_PARAM, .var = param_intern(params, s + start, i - start) };
             EMIT(t);
-            i++;
             continue;
         }
-        // function name
-        if (isalpha((unsigned char)s[i])) {
-            char buf[8]; int len = 0;
-            while (isalpha((unsigned char)s[i]) && len < 7) buf[len++] = s[i++];
-            buf[len] = 0;
-            Token t = { .type = T_FUNC };
-            strncpy(t.func, buf, sizeof t.func);
+        // function, variable or constant name
+        if (isalpha((unsigned char)s[i]) || s[i] == '_') {
+            int start = i;
+            while (isalnum((unsigned char)s[i]) || s[i] == '_') i++;
+            size_t len = i - start;
+            Token t = {0};
+            size_t f = 0, nf = sizeof func_table / sizeof *func_table;
+            int v = 0;
+            while (f < nf && (strlen(func_table[f].name) != len || strncmp(func_table[f].name, s + start, len))) f++;
+            while (v < nvars && (strlen(vars[v]) != len || strncmp(vars[v], s + start, len))) v++;
+            if (f < nf) { t.type = T_FUNC; t.op = func_table[f].op; }
+            else if (v < nvars) { t.type = T_VAR; t.var = v; }
+            else if (len == 1 && s[start] == 'e') { t.type = T_NUMBER; t.value = M_E; }
+            else { fprintf(stderr, "Unknown name '%.*s'\n", (int)len, s + start); exit(1); }
             EMIT(t);
             continue;
         }
         // operators and parens
         Token t = {0};
         switch (s[i]) {
-            case '+': t.type = T_PLUS;  break;
-            case '-': t.type = T_MINUS; break;
-            case '*': t.type = T_MUL;   break;
-            case '/': t.type = T_DIV;   break;
-            case '^': t.type = T_POW;   break;
+            case '+': t.type = T_PLUS;  t.op = OP_ADD; break;
+            case '-': t.type = T_MINUS; t.op = OP_SUB; break;
+            case '*': t.type = T_MUL;   t.op = OP_MUL; break;
+            case '/': t.type = T_DIV;   t.op = OP_DIV; break;
+            case '^': t.type = T_POW;   t.op = OP_POW; break;
             case '(': t.type = T_LPAREN;break;
             case ')': t.type = T_RPAREN;break;
             default:
@@ -109,9 +225,9 @@ static Token *tokenize(const char *s, int *ntok) {
         if (n > 0) {
             TokenType just = out[n-1].type;
             char next = s[i];
-            if ((just == T_NUMBER || just == T_VAR || just == T_RPAREN)
-             && (isdigit((unsigned char)next) || next=='x' || next=='e' || next=='(' || isalpha((unsigned char)next))) {
-                Token m = { .type = T_MUL };
+            if ((just == T_NUMBER || just == T_VAR || just == T_PARAM || just == T_RPAREN)
+             && (isdigit((unsigned char)next) || next=='(' || isalpha((unsigned char)next) || next=='_' || next=='$')) {
+                Token m = { .type = T_MUL, .op = OP_MUL };
                 EMIT(m);
             }
         }
@@ -120,96 +236,744 @@ static Token *tokenize(const char *s, int *ntok) {
     return out;
 }
 
+/* --- Program assembly --- */
+static void emit(Expr *e, OpCode op, uint32_t arg) {
+    if (e->len == e->cap) {
+        e->cap = e->cap ? 2 * e->cap : 16;
+        e->code = realloc(e->code, e->cap * sizeof *e->code);
+    }
+    e->code[e->len++] = (Instr){ op, arg };
+}
+
+static size_t const_hash(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    bits ^= bits >> 32;             // short constants have their set bits at the top
+    bits *= 0x9E3779B97F4A7C15u;
+    return bits ^ (bits >> 29);
+}
+
+/* Index of v in e's constant pool, added if it is not there yet. Constants
+ * match by bit pattern, so 0.0 and -0.0 stay apart. The pool is indexed by
+ * an open-addressing table kept at most half full, rebuilt from consts when
+ * it grows, so compiling stays linear in the number of constants. */
+static uint32_t add_const(Expr *e, double v) {
+    if (2 * (e->nconsts + 1) > e->ccap) {
+        free(e->cindex);
+        e->ccap = e->ccap ? 2 * e->ccap : 32;
+        e->cindex = calloc(e->ccap, sizeof *e->cindex);
+        for (int i = 0; i < e->nconsts; i++) {
+            size_t h = const_hash(e->consts[i]) & (e->ccap - 1);
+            while (e->cindex[h]) h = (h + 1) & (e->ccap - 1);
+            e->cindex[h] = i + 1;
+        }
+    }
+    size_t h = const_hash(v) & (e->ccap - 1);
+    for (; e->cindex[h]; h = (h + 1) & (e->ccap - 1))
+        if (!memcmp(&e->consts[e->cindex[h] - 1], &v, sizeof v)) return e->cindex[h] - 1;
+    if (e->nconsts == 0) e->consts = malloc(16 * sizeof *e->consts);
+    else if (e->nconsts >= 16 && (e->nconsts & (e->nconsts - 1)) == 0) e->consts = realloc(e->consts, 2 * e->nconsts * sizeof *e->consts);
+    e->consts[e->nconsts] = v;
+    e->cindex[h] = e->nconsts + 1;
+    return e->nconsts++;
+}
+
+// drops the index once no more constants will be added
+static void const_index_free(Expr *e) {
+    free(e->cindex);
+    e->cindex = NULL;
+    e->ccap = 0;
+}
+
+static void emit_token(Expr *e, Token t) {
+    if (t.type == T_NUMBER) emit(e, OP_CONST, add_const(e, t.value));
+    else if (t.type == T_VAR) emit(e, OP_VAR, t.var);
+    else if (t.type == T_PARAM) emit(e, OP_PARAM, t.var);
+    else emit(e, t.op, 0);
+}
+
 /* --- Shunting-Yard → RPN --- */
-static void to_rpn(Token *in, int nin) {
+static void to_rpn(Token *in, int nin, Expr *out) {
     TStack st; ts_init(&st);
-    free(rpn); rpn = NULL; rpn_len = 0; int cap = 0;
     for (int i = 0; i < nin; i++) {
         Token tok = in[i];
-        if (tok.type == T_NUMBER || tok.type == T_VAR) {
-            if (rpn_len == cap) rpn = realloc(rpn, (cap ? cap*2 : 64) * sizeof *rpn);
-            rpn[rpn_len++] = tok;
+        if (tok.type == T_NUMBER || tok.type == T_VAR || tok.type == T_PARAM) {
+            emit_token(out, tok);
         } else if (tok.type == T_FUNC) {
             ts_push(&st, tok);
         } else if (tok.type == T_PLUS || tok.type == T_MINUS || tok.type == T_MUL || tok.type == T_DIV || tok.type == T_POW) {
             while (!ts_empty(&st)) {
                 Token top = ts_peek(&st);
-                if (top.type == T_FUNC || prec(top.type) > prec(tok.type) || (prec(top.type) == prec(tok.type) && !is_right_assoc(tok.type))) {
-                    if (rpn_len == cap) rpn = realloc(rpn, (cap ? cap*2 : 64) * sizeof *rpn);
-                    rpn[rpn_len++] = ts_pop(&st);
-                } else break;
+                if (top.type == T_FUNC || prec(top.type) > prec(tok.type) || (prec(top.type) == prec(tok.type) && !is_right_assoc(tok.type)))
+                    emit_token(out, ts_pop(&st));
+                else break;
             }
             ts_push(&st, tok);
         } else if (tok.type == T_LPAREN) {
             ts_push(&st, tok);
         } else if (tok.type == T_RPAREN) {
-            while (!ts_empty(&st) && ts_peek(&st).type != T_LPAREN) {
-                if (rpn_len == cap) rpn = realloc(rpn, (cap ? cap*2 : 64) * sizeof *rpn);
-                rpn[rpn_len++] = ts_pop(&st);
-            }
+            while (!ts_empty(&st) && ts_peek(&st).type != T_LPAREN)
+                emit_token(out, ts_pop(&st));
             if (ts_empty(&st)) { fprintf(stderr,"Mismatched parentheses\n"); exit(1); }
             ts_pop(&st);
-            if (!ts_empty(&st) && ts_peek(&st).type == T_FUNC) {
-                if (rpn_len == cap) rpn = realloc(rpn, (cap ? cap*2 : 64) * sizeof *rpn);
-                rpn[rpn_len++] = ts_pop(&st);
-            }
+            if (!ts_empty(&st) && ts_peek(&st).type == T_FUNC)
+                emit_token(out, ts_pop(&st));
         }
     }
     while (!ts_empty(&st)) {
         Token t = ts_pop(&st);
         if (t.type == T_LPAREN || t.type == T_RPAREN) { fprintf(stderr,"Mismatched parentheses\n"); exit(1); }
-        if (rpn_len == cap) rpn = realloc(rpn, (cap ? cap*2 : 64) * sizeof *rpn);
-        rpn[rpn_len++] = t;
+        emit_token(out, t);
     }
     ts_free(&st);
 }
 
-/* --- Evaluate RPN --- */
-static double eval_rpn(double x) {
-    double *stk = malloc(rpn_len * sizeof *stk);
-    int sp = 0;
-    for (int i = 0; i < rpn_len; i++) {
-        Token *t = &rpn[i];
-        if (t->type == T_NUMBER) stk[sp++] = t->value;
-        else if (t->type == T_VAR) stk[sp++] = x;
-        else if (t->type == T_FUNC) {
+/* --- Stack depth ---
+ * Walks the program once, the way eval_rpn() will, so malformed input is
+ * rejected at parse time and the evaluator never has to bounds-check. */
+static int rpn_depth(const Expr *e) {
+    int sp = 0, depth = 0;
+    for (int i = 0; i < e->len; i++) {
+        OpCode op = e->code[i].op;
+        if (op == OP_CONST || op == OP_VAR || op == OP_PARAM || op == OP_LOAD) sp++;
+        else if (op == OP_STORE) {
+            if (sp < 1) { fprintf(stderr,"Stack underflow in store\n"); exit(1); }
+        } else if (op == OP_DUP) {
+            if (sp < 1) { fprintf(stderr,"Stack underflow in dup\n"); exit(1); }
+            sp++;
+        } else if (op >= OP_SIN) {
             if (sp < 1) { fprintf(stderr,"Stack underflow in func\n"); exit(1); }
-            double v = stk[--sp], r;
-            if (!strcmp(t->func,"sin")) r = sin(v);
-            else if (!strcmp(t->func,"cos")) r = cos(v);
-            else if (!strcmp(t->func,"tan")) r = tan(v);
-            else if (!strcmp(t->func,"exp")) r = exp(v);
-            else if (!strcmp(t->func,"log")) r = log(v);
-            else if (!strcmp(t->func,"sqrt")) r = sqrt(v);
-            else { fprintf(stderr,"Unknown func '%s'\n", t->func); exit(1); }
-            stk[sp++] = r;
         } else {
             if (sp < 2) { fprintf(stderr,"Stack underflow in op\n"); exit(1); }
-            double b = stk[--sp], a = stk[--sp], r = 0;
-            switch (t->type) {
-                case T_PLUS:  r = a + b; break;
-                case T_MINUS: r = a - b; break;
-                case T_MUL:   r = a * b; break;
-                case T_DIV:   r = a / b; break;
-                case T_POW:   r = pow(a, b); break;
-                default: break;
-            }
-            stk[sp++] = r;
+            sp--;
         }
+        if (sp > depth) depth = sp;
     }
     if (sp != 1) { fprintf(stderr,"RPN eval ended with %d elems\n", sp); exit(1); }
-    double out = stk[0]; free(stk);
+    return depth;
+}
+
+/* --- Optimisation pass ---
+ * Rewrites the program from to_rpn() in a single pass, tracking where each
+ * operand's code starts in the output so whole subexpressions can be
+ * dropped or replaced:
+ *   - operators and functions whose operands are all constants are folded,
+ *     using the same libm calls the evaluator would make; parameters are
+ *     not constants, since their values change after compilation;
+ *   - identities that hold bit-for-bit under IEEE 754 are removed: x*1,
+ *     1*x, x/1, x^1, x-(+0), x+(-0), (-0)+x, and x^0 = 1^x = 1. x+0 and
+ *     x*0 are kept since they differ for x = -0, NaN and infinities;
+ *   - x^n for integer 2 <= n <= EXPR_POW_CHAIN_MAX becomes a multiply
+ *     chain instead of a pow() call. Negative n keeps pow(): 1/chain
+ *     overflows to inf, or underflows to 0, long before pow(x, n) does;
+ *   - x/c becomes x*(1/c) when 1/c is exact, i.e. c is a power of two.
+ *     Define EXPR_FAST_RECIPROCAL to do it for every constant, at the
+ *     cost of up to an ulp of error.
+ * It runs before CSE, on programs without OP_LOAD/OP_STORE. */
+#define EXPR_POW_CHAIN_MAX 16
+
+static double fold(OpCode op, double a, double b) {
+    switch (op) {
+        case OP_ADD:  return a + b;
+        case OP_SUB:  return a - b;
+        case OP_MUL:  return a * b;
+        case OP_DIV:  return a / b;
+        case OP_POW:  return pow(a, b);
+        case OP_SIN:  return sin(a);
+        case OP_COS:  return cos(a);
+        case OP_TAN:  return tan(a);
+        case OP_EXP:  return exp(a);
+        case OP_LOG:  return log(a);
+        case OP_SQRT: return sqrt(a);
+        default:      return NAN;
+    }
+}
+
+static int same_bits(double a, double b) { return !memcmp(&a, &b, sizeof a); }
+
+// true if code[start, end) is a single constant; its value goes to *v
+static int single_const(const Expr *e, int start, int end, double *v) {
+    if (end - start != 1 || e->code[start].op != OP_CONST) return 0;
+    *v = e->consts[e->code[start].arg];
+    return 1;
+}
+
+static void cut(Expr *e, int from, int to) {
+    memmove(&e->code[from], &e->code[to], (e->len - to) * sizeof *e->code);
+    e->len -= to - from;
+}
+
+// raises the value on top of the stack to the n-th power, n >= 1
+static void emit_pow_chain(Expr *e, int n) {
+    if (n == 1) return;
+    if (n % 2 == 0) { emit_pow_chain(e, n / 2); emit(e, OP_DUP, 0); emit(e, OP_MUL, 0); }
+    else { emit(e, OP_DUP, 0); emit_pow_chain(e, n - 1); emit(e, OP_MUL, 0); }
+}
+
+static int exact_reciprocal(double c, double *r) {
+    int ex;
+    *r = 1.0 / c;
+#ifdef EXPR_FAST_RECIPROCAL
+    return isnormal(c) && isnormal(*r);
+#else
+    return isnormal(c) && isnormal(*r) && fabs(frexp(c, &ex)) == 0.5;
+#endif
+}
+
+// operands are code[sa, sb) and code[sb, len); emits op or a cheaper equivalent
+static void simplify_binop(Expr *e, OpCode op, int sa, int sb) {
+    double a, b, r;
+    int ca = single_const(e, sa, sb, &a), cb = single_const(e, sb, e->len, &b);
+    if (ca && cb) { e->len = sa; emit(e, OP_CONST, add_const(e, fold(op, a, b))); return; }
+    if (cb) {
+        if ((op == OP_MUL || op == OP_DIV || op == OP_POW) && b == 1.0) { e->len = sb; return; }
+        if ((op == OP_SUB && same_bits(b, 0.0)) || (op == OP_ADD && same_bits(b, -0.0))) { e->len = sb; return; }
+        if (op == OP_POW && b == 0.0) { e->len = sa; emit(e, OP_CONST, add_const(e, 1.0)); return; }
+        if (op == OP_POW && b == trunc(b) && b > 0 && b <= EXPR_POW_CHAIN_MAX) {
+            e->len = sb;
+            emit_pow_chain(e, (int)b);
+            return;
+        }
+        if (op == OP_DIV && exact_reciprocal(b, &r)) {
+            e->code[sb].arg = add_const(e, r);
+            op = OP_MUL;
+        }
+    } else if (ca) {
+        if ((op == OP_MUL && a == 1.0) || (op == OP_ADD && same_bits(a, -0.0))) { cut(e, sa, sb); return; }
+        if (op == OP_POW && a == 1.0) { e->len = sa; emit(e, OP_CONST, add_const(e, 1.0)); return; }
+    }
+    emit(e, op, 0);
+}
+
+static Expr *optimize_rpn(const Expr *in) {
+    Expr *out = calloc(1, sizeof *out);
+    int *start = malloc(in->len * sizeof *start), sp = 0;
+    for (int i = 0; i < in->len; i++) {
+        Instr ins = in->code[i];
+        double a;
+        if (ins.op == OP_CONST || ins.op == OP_VAR || ins.op == OP_PARAM || ins.op == OP_DUP) {
+            start[sp++] = out->len;
+            if (ins.op == OP_CONST) emit(out, OP_CONST, add_const(out, in->consts[ins.arg]));
+            else emit(out, ins.op, ins.arg);
+        } else if (ins.op >= OP_SIN) {
+            if (single_const(out, start[sp - 1], out->len, &a)) {
+                out->len = start[sp - 1];
+                emit(out, OP_CONST, add_const(out, fold(ins.op, a, 0)));
+            } else emit(out, ins.op, 0);
+        } else {
+            sp--;
+            simplify_binop(out, ins.op, start[sp - 1], start[sp]);
+        }
+    }
+    free(start);
+    // drop constants that were folded away
+    Expr packed = { .code = out->code, .len = out->len };
+    for (int i = 0; i < out->len; i++)
+        if (out->code[i].op == OP_CONST)
+            out->code[i].arg = add_const(&packed, out->consts[out->code[i].arg]);
+    free(out->consts);
+    const_index_free(out);
+    const_index_free(&packed);
+    out->consts = packed.consts;
+    out->nconsts = packed.nconsts;
+    out->depth = rpn_depth(out);
     return out;
 }
 
-/* --- Public API --- */
-static double _eval(double x) { return eval_rpn(x); }
-double (*parse_function(const char *expr))(double) {
+/* --- Expression DAG ---
+ * Nodes are hash-consed: node_new() returns the existing node when one with
+ * the same operator and the same (already interned) operands exists, so two
+ * pointers are equal exactly when the subexpressions are identical. The
+ * arena owns every node and releases them all at once. */
+typedef struct sNode {
+    OpCode op;
+    uint32_t arg;              /* OP_VAR: variable index, OP_PARAM: parameter index */
+    double value;              /* OP_CONST */
+    struct sNode *l, *r;       /* operands; r is NULL for functions */
+    int uses;                  /* parents referencing this node, for dag_emit() */
+    int slot;                  /* slot holding its value once emitted, or -1 */
+    struct sNode *deriv;       /* memoised derivative, see symbolic.h */
+    signed char total;         /* memoised node_total() of symbolic.h, -1 until asked */
+} Node;
+
+typedef struct {
+    Node **all; int n, cap;
+    Node **table; int tcap;    /* open-addressing intern table, at most half full */
+} NodeArena;
+
+static size_t node_hash(const Node *n) {
+    uint64_t bits;
+    memcpy(&bits, &n->value, sizeof bits);
+    size_t h = (size_t)n->op * 0x9E3779B97F4A7C15u;
+    h ^= (bits + n->arg) * 0xC2B2AE3D27D4EB4Fu;
+    h ^= (uintptr_t)n->l * 0x165667B19E3779F9u;
+    h ^= (uintptr_t)n->r * 0x27D4EB2F165667C5u;
+    return h ^ (h >> 29);
+}
+
+static int node_same(const Node *a, const Node *b) {
+    return a->op == b->op && a->arg == b->arg && same_bits(a->value, b->value) && a->l == b->l && a->r == b->r;
+}
+
+static Node *node_new(NodeArena *A, Node proto) {
+    if (2 * (A->n + 1) > A->tcap) {
+        free(A->table);
+        A->tcap = A->tcap ? A->tcap * 2 : 128;
+        A->table = calloc(A->tcap, sizeof *A->table);
+        for (int i = 0; i < A->n; i++) {
+            size_t h = node_hash(A->all[i]) & (A->tcap - 1);
+            while (A->table[h]) h = (h + 1) & (A->tcap - 1);
+            A->table[h] = A->all[i];
+        }
+    }
+    size_t h = node_hash(&proto) & (A->tcap - 1);
+    for (; A->table[h]; h = (h + 1) & (A->tcap - 1))
+        if (node_same(A->table[h], &proto)) return A->table[h];
+
+    if (A->n == A->cap) A->all = realloc(A->all, (A->cap = A->cap ? A->cap * 2 : 64) * sizeof *A->all);
+    Node *n = malloc(sizeof *n);
+    *n = proto;
+    n->uses = 0;
+    n->slot = -1;
+    n->deriv = NULL;
+    n->total = -1;
+    A->all[A->n++] = n;
+    return A->table[h] = n;
+}
+
+static void arena_free(NodeArena *A) {
+    for (int i = 0; i < A->n; i++) free(A->all[i]);
+    free(A->all);
+    free(A->table);
+}
+
+static Node *mk_const(NodeArena *A, double v) { return node_new(A, (Node){ .op = OP_CONST, .value = v }); }
+static Node *mk_var(NodeArena *A, uint32_t arg) { return node_new(A, (Node){ .op = OP_VAR, .arg = arg }); }
+static Node *mk_param(NodeArena *A, uint32_t arg) { return node_new(A, (Node){ .op = OP_PARAM, .arg = arg }); }
+
+// builds the DAG of a program as written; mk_un/mk_bin may simplify, if given
+static Node *tree_from_expr(NodeArena *A, const Expr *e,
+                            Node *(*mk_un)(NodeArena *, OpCode, Node *),
+                            Node *(*mk_bin)(NodeArena *, OpCode, Node *, Node *)) {
+    Node **stk = malloc((e->depth + e->nslots) * sizeof *stk), **slot = stk + e->depth;
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        const Instr *ip = &e->code[i];
+        switch (ip->op) {
+            case OP_CONST: stk[sp++] = mk_const(A, e->consts[ip->arg]); break;
+            case OP_VAR:   stk[sp++] = mk_var(A, ip->arg); break;
+            case OP_PARAM: stk[sp++] = mk_param(A, ip->arg); break;
+            case OP_DUP:   stk[sp] = stk[sp - 1]; sp++; break;
+            case OP_LOAD:  stk[sp++] = slot[ip->arg]; break;
+            case OP_STORE: slot[ip->arg] = stk[sp - 1]; break;
+            default:
+                if (ip->op >= OP_SIN)
+                    stk[sp - 1] = mk_un ? mk_un(A, ip->op, stk[sp - 1]) : node_new(A, (Node){ .op = ip->op, .l = stk[sp - 1] });
+                else {
+                    sp--;
+                    stk[sp - 1] = mk_bin ? mk_bin(A, ip->op, stk[sp - 1], stk[sp])
+                                         : node_new(A, (Node){ .op = ip->op, .l = stk[sp - 1], .r = stk[sp] });
+                }
+        }
+    }
+    Node *root = stk[0];
+    free(stk);
+    return root;
+}
+
+static void dag_count_uses(Node *n) {
+    if (n->uses++ > 0 || n->l == NULL) return;
+    dag_count_uses(n->l);
+    if (n->r && n->r != n->l) dag_count_uses(n->r);
+}
+
+/* Emits each node once. A node with several parents is stored to a slot
+ * right after it is computed and every later use loads it back; x*x style
+ * nodes whose operands coincide use OP_DUP instead. Constants, variables and
+ * parameters are cheaper to push again than to load, so they never get slots. */
+static void dag_emit(Expr *out, Node *n) {
+    if (n->slot >= 0) { emit(out, OP_LOAD, n->slot); return; }
+    if (n->op == OP_CONST) { emit(out, OP_CONST, add_const(out, n->value)); return; }
+    if (n->op == OP_VAR || n->op == OP_PARAM) { emit(out, n->op, n->arg); return; }
+    dag_emit(out, n->l);
+    if (n->r == n->l) emit(out, OP_DUP, 0);
+    else if (n->r) dag_emit(out, n->r);
+    emit(out, n->op, 0);
+    if (n->uses > 1) {
+        n->slot = out->nslots++;
+        emit(out, OP_STORE, n->slot);
+    }
+}
+
+static Expr *dag_to_expr(Node *root) {
+    Expr *e = calloc(1, sizeof *e);
+    dag_count_uses(root);
+    dag_emit(e, root);
+    const_index_free(e);
+    e->depth = rpn_depth(e);
+    return e;
+}
+
+/* Common-subexpression elimination: interns the program into a DAG and
+ * re-emits it so every distinct subexpression is evaluated once. */
+static Expr *cse_rpn(const Expr *in) {
+    NodeArena A = {0};
+    Expr *out = dag_to_expr(tree_from_expr(&A, in, NULL, NULL));
+    arena_free(&A);
+    return out;
+}
+
+/* --- Public API ---
+ * The evaluator is instantiated once per precision from eval_typed.h:
+ * expr_eval(), expr_eval_batch(), expr_bind() and the rest in double,
+ * expr_evalf() and friends in float, expr_evall() and friends in long
+ * double. All three run the same program; only the arithmetic differs.
+ *
+ * The double batch evaluator takes sin, cos, tan, exp, log and sqrt from
+ * the SIMD kernels in vmath.h, which can differ from libm in the last bit
+ * or two. Build with -DEXPR_STRICT_LIBM to have it call libm like
+ * everything else, and give results bit-identical to expr_eval(). */
+#define EXPR_BATCH 64
+#define EXPR_BATCH_SCRATCH 16384    /* local stack rows for the batch evaluator; more come from the heap */
+#define EXPR_BIND_SLOTS 8
+
+#define TYPED_T double
+#define TYPED_SFX
+#ifndef EXPR_STRICT_LIBM
+#include "vmath.h"
+#define EXPR_VMATH
+#endif
+#include "eval_typed.h"
+
+#define TYPED_T float
+#define TYPED_SFX f
+#include "eval_typed.h"
+
+#define TYPED_T long double
+#define TYPED_SFX l
+#include "eval_typed.h"
+
+/* Picks the precision from the argument type: expr_eval_tg(e, 1.0f) runs
+ * in float, expr_eval_tg(e, 1.0L) in long double, anything else in double. */
+#define expr_eval_tg(e, x) \
+    _Generic((x), float: expr_evalf, long double: expr_evall, default: expr_eval)(e, x)
+#define expr_eval_vars_tg(e, vars) \
+    _Generic((vars), float *: expr_eval_varsf, const float *: expr_eval_varsf, \
+             long double *: expr_eval_varsl, const long double *: expr_eval_varsl, \
+             default: expr_eval_vars)(e, vars)
+#define expr_eval_batch_tg(e, xs, ys, n) \
+    _Generic((ys), float *: expr_eval_batchf, long double *: expr_eval_batchl, \
+             default: expr_eval_batch)(e, xs, ys, n)
+
+/* Same as expr_eval() with a caller-owned stack of at least
+ * e->depth + e->nslots doubles. */
+double expr_eval_with(const Expr *e, double *stack, double x) {
+    return eval_rpn(e, stack, &x);
+}
+
+void expr_dump(const Expr *e, FILE *out) {
+    for (int i = 0; i < e->len; i++) {
+        const Instr *in = &e->code[i];
+        if (in->op == OP_CONST) fprintf(out, "%g ", e->consts[in->arg]);
+        else if (in->op == OP_VAR && e->vars) fprintf(out, "%s ", e->vars[in->arg]);
+        else if (in->op == OP_PARAM && e->params) fprintf(out, "$%s ", e->params->names[in->arg]);
+        else if (in->op == OP_LOAD || in->op == OP_STORE) fprintf(out, "%s%u ", op_name(in->op), in->arg);
+        else fprintf(out, "%s ", op_name(in->op));
+    }
+    fprintf(out, "\n");
+}
+
+// releases e's trampolines in every precision
+void expr_unbind(const Expr *e) {
+    unbind_pool(e);
+    unbind_poolf(e);
+    unbind_pooll(e);
+}
+
+static void param_release(ParamTable *p) {
+    if (p == NULL || atomic_fetch_sub(&p->refs, 1) > 0) return;
+    for (int i = 0; i < p->n; i++) free(p->names[i]);
+    free(p->names);
+    free(p->values);
+    free(p);
+}
+
+/* Drops one reference; the last one unbinds e and frees it. A cache handle
+ * then lets go of the program it shares. */
+static void expr_release(const Expr *e) {
+    if (atomic_fetch_sub(&((Expr *)e)->refs, 1) > 0) return;
+    expr_unbind(e);
+    if (e->base) {
+        expr_release(e->base);
+        free((Expr *)e);
+        return;
+    }
+    free(e->code);
+    free(e->consts);
+    free(e->cindex);
+    for (int i = 0; i < e->nvars && e->vars; i++) free(e->vars[i]);
+    free(e->vars);
+    param_release(e->params);
+    free((Expr *)e);
+}
+
+void expr_free(const Expr *e) {
+    if (e == NULL) return;
+    expr_release(e);
+}
+
+// gives e its own copy of the variable names
+static void expr_set_vars(Expr *e, const char *const *vars, int nvars) {
+    e->nvars = nvars;
+    e->vars = malloc(nvars * sizeof *e->vars);
+    for (int i = 0; i < nvars; i++) e->vars[i] = strdup(vars[i]);
+}
+
+static Expr *compile_function(const char *expr, const char *const *vars, int nvars) {
     int ntok;
-    Token *tokens = tokenize(expr, &ntok);
-    to_rpn(tokens, ntok);
+    ParamTable params = {0};
+    Token *tokens = tokenize(expr, &ntok, vars, nvars, &params);
+    Expr *raw = calloc(1, sizeof *raw);
+    to_rpn(tokens, ntok, raw);
+    raw->depth = rpn_depth(raw);
     free(tokens);
-    return &_eval;
+    Expr *opt = optimize_rpn(raw);
+    Expr *e = cse_rpn(opt);
+    expr_set_vars(e, vars, nvars);
+    if (params.n) {
+        e->params = malloc(sizeof *e->params);
+        *e->params = params;
+        e->params->values = calloc(params.n, sizeof *params.values);
+    }
+#ifdef DEBUG
+    printf("before: "); expr_dump(raw, stdout);
+    printf("after:  "); expr_dump(e, stdout);
+#endif
+    expr_free(raw);
+    expr_free(opt);
+    return e;
+}
+
+/* --- Compiled-expression cache ---
+ * Each thread keeps the last EXPR_CACHE_SIZE programs parse_function_vars()
+ * compiled, keyed by the expression text with insignificant whitespace
+ * removed plus the variable names. A repeated parse costs one hash lookup
+ * and returns a handle of its own: a copy of the Expr header that shares
+ * the cached program and holds a reference to it. Being distinct, handles
+ * bind and unbind independently, so freeing one never clears a trampoline
+ * another caller is using. The program goes away once every handle is
+ * freed and the cache has evicted it. A thread's cache is emptied when
+ * the thread exits; expr_cache_clear() empties the calling thread's cache
+ * at any time, which is the way to release the main thread's before exit
+ * (a leak checker will report it otherwise). Define EXPR_CACHE_SIZE as 0
+ * to compile every call afresh. */
+#ifndef EXPR_CACHE_SIZE
+#define EXPR_CACHE_SIZE 512
+#endif
+
+typedef struct { size_t hits, misses, evictions; int entries; } ExprCacheStats;
+
+#if EXPR_CACHE_SIZE > 0
+typedef struct {
+    char *key;
+    uint64_t hash;
+    const Expr *e;
+    int chain;                 /* next entry in the same bucket */
+    int prev, next;            /* neighbours in recency order */
+} CacheEntry;
+
+/* Links are entry index + 1 so that 0, the zero-initialised value, means none. */
+static _Thread_local struct {
+    CacheEntry ent[EXPR_CACHE_SIZE];
+    int bucket[2 * EXPR_CACHE_SIZE];
+    int head, tail;            /* most and least recently used */
+    ExprCacheStats stats;
+} expr_cache;
+
+// FNV-1a
+static uint64_t cache_hash(const char *s) {
+    uint64_t h = 0xCBF29CE484222325u;
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 0x100000001B3u;
+    return h;
+}
+
+static int is_word_char(char c) { return isalnum((unsigned char)c) || c == '_' || c == '.'; }
+
+/* Writes the cache key into key: the text without whitespace, except that a
+ * run of it between two word characters stays as one space ("2 3" must not
+ * turn into "23"), then each variable name after a newline. */
+static void cache_key(char *key, const char *expr, const char *const *vars, int nvars) {
+    char *k = key;
+    for (const char *p = expr; *p; p++) {
+        if (!isspace((unsigned char)*p)) { *k++ = *p; continue; }
+        while (isspace((unsigned char)p[1])) p++;
+        if (k > key && is_word_char(k[-1]) && is_word_char(p[1])) *k++ = ' ';
+    }
+    for (int i = 0; i < nvars; i++) {
+        size_t n = strlen(vars[i]);
+        *k++ = '\n';
+        memcpy(k, vars[i], n);
+        k += n;
+    }
+    *k = 0;
+}
+
+static void cache_unlink(int i) {
+    CacheEntry *c = &expr_cache.ent[i];
+    if (c->prev) expr_cache.ent[c->prev - 1].next = c->next; else expr_cache.head = c->next;
+    if (c->next) expr_cache.ent[c->next - 1].prev = c->prev; else expr_cache.tail = c->prev;
+}
+
+static void cache_push_front(int i) {
+    CacheEntry *c = &expr_cache.ent[i];
+    c->prev = 0;
+    c->next = expr_cache.head;
+    if (expr_cache.head) expr_cache.ent[expr_cache.head - 1].prev = i + 1; else expr_cache.tail = i + 1;
+    expr_cache.head = i + 1;
+}
+
+// removes entry i from its bucket and the recency list and drops its program
+static void cache_evict(int i) {
+    CacheEntry *c = &expr_cache.ent[i];
+    int *link = &expr_cache.bucket[c->hash % (2 * EXPR_CACHE_SIZE)];
+    while (*link != i + 1) link = &expr_cache.ent[*link - 1].chain;
+    *link = c->chain;
+    cache_unlink(i);
+    free(c->key);
+    expr_release(c->e);
+    *c = (CacheEntry){0};
+    expr_cache.stats.entries--;
+}
+
+// a new handle on the cached program p
+static const Expr *expr_handle(const Expr *p) {
+    Expr *h = malloc(sizeof *h);
+    *h = *p;
+    h->refs = 0;
+    h->base = p;
+    atomic_fetch_add(&((Expr *)p)->refs, 1);
+    return h;
+}
+
+ExprCacheStats expr_cache_stats(void) { return expr_cache.stats; }
+
+void expr_cache_clear(void) {
+    while (expr_cache.tail) {
+        cache_evict(expr_cache.tail - 1);
+        expr_cache.stats.evictions++;
+    }
+}
+
+// a thread-specific key whose destructor clears the exiting thread's cache
+static pthread_key_t expr_cache_key;
+static pthread_once_t expr_cache_once = PTHREAD_ONCE_INIT;
+
+static void cache_thread_exit(void *unused) { (void)unused; expr_cache_clear(); }
+static void cache_key_create(void) { pthread_key_create(&expr_cache_key, cache_thread_exit); }
+
+// arms the destructor for this thread; the key's value only has to be non-NULL
+static void cache_arm_thread_exit(void) {
+    pthread_once(&expr_cache_once, cache_key_create);
+    pthread_setspecific(expr_cache_key, &expr_cache);
+}
+#else
+ExprCacheStats expr_cache_stats(void) { return (ExprCacheStats){0}; }
+void expr_cache_clear(void) {}
+#endif
+
+/* Compiles an expression over the variables vars[0..nvars-1]; each name is
+ * bound to its index here, and evaluation takes the values in that order:
+ *
+ *     const Expr *f = parse_function_vars("x*y + t", (const char *[]){ "x", "y", "t" }, 3);
+ *     double v = expr_eval_vars(f, (double[]){ 1, 2, 3 });
+ *
+ * The result may be shared with earlier callers through the cache; release
+ * it with expr_free() either way. Text with $parameters is compiled afresh
+ * every time, so each caller gets a parameter table of its own. */
+const Expr *parse_function_vars(const char *expr, const char *const *vars, int nvars) {
+#if EXPR_CACHE_SIZE > 0
+    if (strchr(expr, '$')) return compile_function(expr, vars, nvars);
+    size_t klen = strlen(expr) + 1;
+    for (int i = 0; i < nvars; i++) klen += strlen(vars[i]) + 1;
+    char local[256], *key = expr_scratch(local, sizeof local, klen);
+    cache_key(key, expr, vars, nvars);
+    uint64_t h = cache_hash(key);
+    int *bucket = &expr_cache.bucket[h % (2 * EXPR_CACHE_SIZE)];
+    for (int i = *bucket; i; i = expr_cache.ent[i - 1].chain) {
+        CacheEntry *c = &expr_cache.ent[i - 1];
+        if (c->hash != h || strcmp(c->key, key)) continue;
+        cache_unlink(i - 1);
+        cache_push_front(i - 1);
+        expr_cache.stats.hits++;
+        expr_scratch_free(local, key);
+        return expr_handle(c->e);
+    }
+    expr_cache.stats.misses++;
+
+    // entries fill the table front to back; once it is full the LRU one makes room
+    Expr *e = compile_function(expr, vars, nvars);
+    int slot = expr_cache.stats.entries;
+    if (slot == 0) cache_arm_thread_exit();
+    if (slot == EXPR_CACHE_SIZE) {
+        slot = expr_cache.tail - 1;
+        cache_evict(slot);
+        expr_cache.stats.evictions++;
+    }
+    expr_cache.stats.entries++;
+    expr_cache.ent[slot] = (CacheEntry){ .key = strdup(key), .hash = h, .e = e, .chain = *bucket };
+    expr_scratch_free(local, key);
+    *bucket = slot + 1;
+    cache_push_front(slot);
+    return expr_handle(e);
+#else
+    return compile_function(expr, vars, nvars);
+#endif
+}
+
+const Expr *parse_function(const char *expr) {
+    return parse_function_vars(expr, (const char *const[]){ "x" }, 1);
+}
+
+/* --- Parameters ---
+ *
+ *     const Expr *f = parse_function("$a*sin(x) - $b*x");
+ *     int a = expr_param_index(f, "a"), b = expr_param_index(f, "b");
+ *     for (...) {
+ *         expr_set_param(f, a, ...);
+ *         expr_set_param(f, b, ...);
+ *         double root = bisection_meth(0, 2, 1e-9, expr_bind(f));
+ *     }
+ *
+ * Programs already built from f (expr_jit(), expr_reg_compile()) and
+ * derivatives of it see the new values too. */
+
+// index of parameter name, with or without its '$', or -1 if e has none such
+int expr_param_index(const Expr *e, const char *name) {
+    if (*name == '$') name++;
+    for (int i = 0; e->params && i < e->params->n; i++)
+        if (strcmp(e->params->names[i], name) == 0) return i;
+    return -1;
+}
+
+// true if i names one of e's parameters; warns on behalf of caller otherwise
+static int param_ok(const Expr *e, int i, const char *caller) {
+    int n = e->params ? e->params->n : 0;
+    if (i >= 0 && i < n) return 1;
+    fprintf(stderr, "WARNING: %s: no parameter %d, the expression has %d\n", caller, i, n);
+    return 0;
+}
+
+// 0 on success, -1 if i is out of range (such as expr_param_index()'s -1)
+int expr_set_param(const Expr *e, int i, double v) {
+    if (!param_ok(e, i, "expr_set_param")) return -1;
+    e->params->values[i] = v;
+    return 0;
+}
+
+// NaN if i is out of range
+double expr_get_param(const Expr *e, int i) {
+    if (!param_ok(e, i, "expr_get_param")) return NAN;
+    return e->params->values[i];
 }
 
 /* --- EXAMPLE of how you'd use it: --- */
@@ -220,51 +984,16 @@ int main(void){
     printf("Enter f(x): ");
     if(!fgets(expr, sizeof expr, stdin)) return 0;
     expr[strcspn(expr,"\n")] = 0;
-    double (*f)(double) = parse_function(expr);
+    const Expr *f = parse_function(expr);
 
-    double root = bisection_meth(0, 2, 1e-6, f);
+    double (*fn)(double) = expr_bind(f);
+    if (fn == NULL) return 1;
+    double root = bisection_meth(0, 2, 1e-6, fn);
     printf("  → root ~= %.8f\n", root);
+    expr_free(f);
     return 0;
 }
 
 #endif
-// --- these mirror your parser's static rpn[] and rpn_len ---
-extern Token *rpn;        // declared in parser.c
-extern int    rpn_len;    // declared in parser.c
-
-static Token *rpn_f = NULL;
-static int    rpn_len_f;
-
-static Token *rpn_fder = NULL;
-static int    rpn_len_fder;
-
-// copy the parser's current RPN into rpn_f / rpn_fder
-static void save_current_rpn(Token **dst, int *dst_len) {
-    if (*dst) free(*dst);
-    *dst_len = rpn_len;
-    *dst = malloc(rpn_len * sizeof(Token));
-    memcpy(*dst, rpn, rpn_len * sizeof(Token));
-}
 
-// swap in a saved RPN before calling eval_rpn()
-static double call_saved_rpn(Token *src, int src_len, double x) {
-    // swap
-    Token *old_rpn   = rpn;
-    int    old_len   = rpn_len;
-    rpn     = src;
-    rpn_len = src_len;
-    // eval
-    double y = eval_rpn(x);
-    // restore
-    rpn     = old_rpn;
-    rpn_len = old_len;
-    return y;
-}
-
-static double call_f(double x) {
-    return call_saved_rpn(rpn_f,   rpn_len_f,   x);
-}
-
-static double call_fder(double x) {
-    return call_saved_rpn(rpn_fder, rpn_len_fder, x);
-}
+#endif // RPN_PARSER_H
@@ -0,0 +1,275 @@
+#ifndef RPN_REGVM_H
+#define RPN_REGVM_H
+
+/* --- Register VM ---
+ * expr_reg_compile() translates a stack program into three-address code
+ * over a register file whose size is fixed at compile time:
+ *
+ *     [ variables | constants | parameters | stack temporaries | CSE slots ]
+ *
+ * Variables, constants and parameters are copied into their registers when
+ * a call starts, so they become plain operands: x*c, x+y or sin(x) is one
+ * instruction where the stack machine needs two or three pushes and an
+ * operator, and no operand goes through the stack.
+ *
+ * On top of that, the translator emits superinstructions for the patterns
+ * the optimiser and typical models produce:
+ *   - a*b+c, a*b-c and c-a*b become one multiply-add (ROP_MADD, ROP_MSUB,
+ *     ROP_NMADD), which covers a*x+b and Horner-style polynomials;
+ *   - the multiply chains that optimize_rpn() makes for x^n become one
+ *     ROP_POWI, even after CSE has split them up;
+ *   - a result that goes into a CSE slot is computed straight into it.
+ * Every instruction performs the same IEEE operations in the same order as
+ * eval_rpn(), so results are bit-identical. Define EXPR_FUSED_FMA to let
+ * the multiply-adds use fma() instead, which rounds once and is faster on
+ * hardware FMA but no longer matches the stack evaluator to the bit.
+ *
+ * Registers are addressed with one byte; a program needing more than 256
+ * gets NULL from expr_reg_compile() and stays on the stack evaluator.
+ * Parameters are read from the expression's table on every call, so the
+ * program must not outlive the expression it was compiled from. */
+
+#include "parser.h"
+
+typedef enum {
+    ROP_MOV,
+    ROP_ADD, ROP_SUB, ROP_MUL, ROP_DIV, ROP_POW,
+    ROP_SIN, ROP_COS, ROP_TAN, ROP_EXP, ROP_LOG, ROP_SQRT,
+    ROP_MADD, ROP_MSUB, ROP_NMADD,      /* a*b+c, a*b-c, c-a*b */
+    ROP_POWI                            /* a^n as optimize_rpn's multiply chain */
+} RegOp;
+
+typedef struct {
+    uint8_t op, dst, a, b, c;
+    uint8_t n;                          /* ROP_POWI exponent */
+} RInstr;
+
+typedef struct {
+    RInstr *code;
+    int     len;
+    double *consts;                     /* copied into registers nvars.. */
+    int     nconsts;
+    const ParamTable *params;           /* values copied in after the constants */
+    int     nvars;
+    int     nregs;
+    int     result;                     /* register holding the value at the end */
+} RegProgram;
+
+static const char *const rop_names[] = {
+    "mov", "add", "sub", "mul", "div", "pow", "sin", "cos", "tan", "exp", "log", "sqrt",
+    "madd", "msub", "nmadd", "powi"
+};
+
+/* The multiply chain emit_pow_chain() builds for v^n, n >= 1, evaluated
+ * from the top bit down: squaring for every bit, times v for every set bit
+ * below the top one, which is the same sequence of products. */
+static double pow_chain(double v, int n) {
+    int bit = 1;
+    while (bit * 2 <= n) bit *= 2;
+    double r = v;
+    for (bit /= 2; bit; bit /= 2) {
+        r = r * r;
+        if (n & bit) r = v * r;
+    }
+    return r;
+}
+
+static void remit(RegProgram *p, RInstr in) {
+    if (p->len == 0) p->code = malloc(16 * sizeof *p->code);
+    else if (p->len >= 16 && (p->len & (p->len - 1)) == 0) p->code = realloc(p->code, 2 * p->len * sizeof *p->code);
+    p->code[p->len++] = in;
+}
+
+/* Powers seen so far: register r holds pow_chain(reg base[r], exp[r]) when
+ * exp[r] > 0. A multiply continuing such a chain, s*s or v*s for even
+ * exponents, becomes one ROP_POWI from the base; the multiplies it skips
+ * are dropped afterwards if nothing else reads them. */
+typedef struct { uint8_t base[256], exp[256]; } PowInfo;
+
+static int pow_of(const PowInfo *P, int r, int base) {
+    if (r == base) return 1;
+    return P->exp[r] && P->base[r] == base ? P->exp[r] : 0;
+}
+
+// register d is about to be overwritten: powers of its old value are gone
+static void pow_clobber(PowInfo *P, int d) {
+    P->exp[d] = 0;
+    for (int r = 0; r < 256; r++)
+        if (P->exp[r] && P->base[r] == d) P->exp[r] = 0;
+}
+
+// removes instructions whose result is never read
+static void reg_dce(RegProgram *p) {
+    uint8_t live[256] = {0};
+    int keep = p->len;
+    live[p->result] = 1;
+    for (int i = p->len - 1; i >= 0; i--) {
+        RInstr in = p->code[i];
+        if (!live[in.dst]) { in.op = 0xFF; p->code[i] = in; keep--; continue; }
+        live[in.dst] = 0;
+        live[in.a] = 1;
+        if (in.op >= ROP_ADD && in.op <= ROP_POW) live[in.b] = 1;
+        if (in.op >= ROP_MADD && in.op <= ROP_NMADD) live[in.b] = live[in.c] = 1;
+    }
+    int j = 0;
+    for (int i = 0; i < p->len; i++)
+        if (p->code[i].op != 0xFF) p->code[j++] = p->code[i];
+    p->len = keep;
+}
+
+RegProgram *expr_reg_compile(const Expr *e) {
+    int K0 = e->nvars, P0 = K0 + e->nconsts, T0 = P0 + (e->params ? e->params->n : 0), S0 = T0 + e->depth;
+    if (S0 + e->nslots > 256) return NULL;
+
+    RegProgram *p = calloc(1, sizeof *p);
+    p->nvars = e->nvars;
+    p->nconsts = e->nconsts;
+    p->params = e->params;
+    p->nregs = S0 + e->nslots;
+    p->consts = malloc((e->nconsts + 1) * sizeof *p->consts);
+    memcpy(p->consts, e->consts, e->nconsts * sizeof *e->consts);
+
+    // reg[i]: register holding stack entry i; no code is needed to push a
+    // variable, constant or slot, or to duplicate an entry
+    uint8_t reg[256];                   // depth <= 256, checked above
+    PowInfo P = {0};
+    int sp = 0;
+    for (int i = 0; i < e->len; i++) {
+        Instr in = e->code[i];
+        RInstr *last = p->len ? &p->code[p->len - 1] : NULL;
+        switch (in.op) {
+            case OP_CONST: reg[sp++] = K0 + in.arg; continue;
+            case OP_VAR:   reg[sp++] = in.arg; continue;
+            case OP_PARAM: reg[sp++] = P0 + in.arg; continue;
+            case OP_LOAD:  reg[sp++] = S0 + in.arg; continue;
+            case OP_DUP:   reg[sp] = reg[sp - 1]; sp++; continue;
+            case OP_STORE: {
+                // compute into the slot directly when the value was just made and nothing aliases it
+                int alias = 0, src = reg[sp - 1], slot = S0 + in.arg;
+                for (int j = 0; j < sp - 1; j++) alias |= reg[j] == src;
+                pow_clobber(&P, slot);
+                if (last && last->dst == src && src >= T0 && src < S0 && !alias) {
+                    last->dst = slot;
+                    P.exp[slot] = P.exp[src];
+                    P.base[slot] = P.base[src];
+                    pow_clobber(&P, src);
+                } else {
+                    remit(p, (RInstr){ .op = ROP_MOV, .dst = slot, .a = src });
+                    P.exp[slot] = P.exp[src];
+                    P.base[slot] = P.base[src];
+                }
+                reg[sp - 1] = slot;
+                continue;
+            }
+            default: break;
+        }
+        if (in.op >= OP_SIN) {
+            uint8_t dst = T0 + sp - 1;
+            pow_clobber(&P, dst);
+            remit(p, (RInstr){ .op = ROP_SIN + (in.op - OP_SIN), .dst = dst, .a = reg[sp - 1] });
+            reg[sp - 1] = dst;
+            continue;
+        }
+        sp--;
+        uint8_t a = reg[sp - 1], b = reg[sp], dst = T0 + sp - 1;
+        // fold a multiply whose result is used only here into the add/sub
+        int alias = 0;
+        for (int j = 0; last && j < sp - 1; j++) alias |= reg[j] == last->dst;
+        if ((in.op == OP_ADD || in.op == OP_SUB) && last && last->op == ROP_MUL && !alias
+            && last->dst >= T0 && last->dst < S0 && (last->dst == a) != (last->dst == b)) {
+            RegOp op = in.op == OP_ADD ? ROP_MADD : last->dst == a ? ROP_MSUB : ROP_NMADD;
+            pow_clobber(&P, dst);
+            *last = (RInstr){ .op = op, .dst = dst, .a = last->a, .b = last->b, .c = last->dst == a ? b : a };
+        } else if (in.op == OP_MUL) {
+            int base = -1, n = 0, m;
+            if (a == b) {
+                base = P.exp[a] ? P.base[a] : a;
+                n = 2 * (P.exp[a] ? P.exp[a] : 1);
+            } else if ((m = pow_of(&P, b, a)) % 2 == 0 && m) {
+                base = a; n = m + 1;
+            } else if ((m = pow_of(&P, a, b)) % 2 == 0 && m) {
+                base = b; n = m + 1;
+            }
+            pow_clobber(&P, dst);
+            if (n >= 3 && n <= 255) remit(p, (RInstr){ .op = ROP_POWI, .dst = dst, .a = base, .n = n });
+            else remit(p, (RInstr){ .op = ROP_MUL, .dst = dst, .a = a, .b = b });
+            if (n >= 2 && n <= 255 && base != dst) { P.exp[dst] = n; P.base[dst] = base; }
+        } else {
+            pow_clobber(&P, dst);
+            remit(p, (RInstr){ .op = ROP_ADD + (in.op - OP_ADD), .dst = dst, .a = a, .b = b });
+        }
+        reg[sp - 1] = dst;
+    }
+    p->result = reg[0];
+    reg_dce(p);
+    return p;
+}
+
+#ifdef EXPR_FUSED_FMA
+#define REG_MADD(a, b, c) fma((a), (b), (c))
+#else
+#define REG_MADD(a, b, c) ((a) * (b) + (c))
+#endif
+
+static double reg_run(const RegProgram *p, double *r) {
+    if (p->params) memcpy(r + p->nvars + p->nconsts, p->params->values, p->params->n * sizeof *r);
+    for (const RInstr *ip = p->code, *end = ip + p->len; ip < end; ip++) {
+        double a = r[ip->a], b = r[ip->b];
+        switch (ip->op) {
+            case ROP_MOV:   r[ip->dst] = a; break;
+            case ROP_ADD:   r[ip->dst] = a + b; break;
+            case ROP_SUB:   r[ip->dst] = a - b; break;
+            case ROP_MUL:   r[ip->dst] = a * b; break;
+            case ROP_DIV:   r[ip->dst] = a / b; break;
+            case ROP_POW:   r[ip->dst] = pow(a, b); break;
+            case ROP_SIN:   r[ip->dst] = sin(a); break;
+            case ROP_COS:   r[ip->dst] = cos(a); break;
+            case ROP_TAN:   r[ip->dst] = tan(a); break;
+            case ROP_EXP:   r[ip->dst] = exp(a); break;
+            case ROP_LOG:   r[ip->dst] = log(a); break;
+            case ROP_SQRT:  r[ip->dst] = sqrt(a); break;
+            case ROP_MADD:  r[ip->dst] = REG_MADD(a, b, r[ip->c]); break;
+            case ROP_MSUB:  r[ip->dst] = REG_MADD(a, b, -r[ip->c]); break;
+            case ROP_NMADD: r[ip->dst] = REG_MADD(-a, b, r[ip->c]); break;
+            case ROP_POWI:  r[ip->dst] = pow_chain(a, ip->n); break;
+        }
+    }
+    return r[p->result];
+}
+
+#undef REG_MADD
+
+double expr_reg_eval_vars(const RegProgram *p, const double *vars) {
+    double r[256];
+    memcpy(r, vars, p->nvars * sizeof *r);
+    memcpy(r + p->nvars, p->consts, p->nconsts * sizeof *r);
+    return reg_run(p, r);
+}
+
+double expr_reg_eval(const RegProgram *p, double x) {
+    double r[256];
+    r[0] = x;
+    memcpy(r + p->nvars, p->consts, p->nconsts * sizeof *r);
+    return reg_run(p, r);
+}
+
+void expr_reg_dump(const RegProgram *p, FILE *out) {
+    for (int i = 0; i < p->len; i++) {
+        const RInstr *in = &p->code[i];
+        fprintf(out, "r%d = %s r%d", in->dst, rop_names[in->op], in->a);
+        if (in->op >= ROP_ADD && in->op <= ROP_POW) fprintf(out, ", r%d", in->b);
+        if (in->op >= ROP_MADD && in->op <= ROP_NMADD) fprintf(out, ", r%d, r%d", in->b, in->c);
+        if (in->op == ROP_POWI) fprintf(out, ", %d", in->n);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "result r%d\n", p->result);
+}
+
+void expr_reg_free(RegProgram *p) {
+    if (p == NULL) return;
+    free(p->code);
+    free(p->consts);
+    free(p);
+}
+
+#endif // RPN_REGVM_H
@@ -0,0 +1,236 @@
+#ifndef RPN_SYMBOLIC_H
+#define RPN_SYMBOLIC_H
+
+/* --- Symbolic differentiation ---
+ * expr_derive() rebuilds the expression tree from a compiled program,
+ * applies the differentiation rules for + - * / ^ and the six functions,
+ * simplifies while building, and compiles the result into a new Expr that
+ * goes through the usual optimisation and CSE passes. The derivative is an
+ * ordinary program, so evaluating it costs no more than evaluating any
+ * expression of that size, and it can be printed with expr_print().
+ *
+ * The simplifier works algebraically (0*u = 0, u-u = 0, ...), which is what
+ * a derivative wants, unlike optimize_rpn() which only removes identities
+ * that are exact in IEEE arithmetic. It still only uses identities that hold
+ * for every real input, so it never changes where an expression is defined:
+ * 0*u and u-u become 0 only when u is defined everywhere, u/u is left alone,
+ * and powers of a common base are merged only when both sides are defined
+ * for the same negative bases. It also runs on the source tree before
+ * differentiating, and must not make f' exist where f does not. */
+
+#include "parser.h"
+
+static int is_num(const Node *n, double v) { return n->op == OP_CONST && n->value == v; }
+static int is_int(double v) { return v == trunc(v); }
+
+// true if n has a finite value for every real value of its variables and parameters
+static int node_total(Node *n) {
+    if (n->total < 0) {
+        switch (n->op) {
+            case OP_CONST: n->total = isfinite(n->value); break;
+            case OP_VAR: case OP_PARAM: n->total = 1; break;
+            case OP_ADD: case OP_SUB: case OP_MUL: n->total = node_total(n->l) && node_total(n->r); break;
+            case OP_DIV:    // by something that is never 0
+                n->total = node_total(n->l) && ((n->r->op == OP_CONST && n->r->value != 0 && isfinite(n->r->value))
+                                                || (n->r->op == OP_EXP && node_total(n->r->l)));
+                break;
+            case OP_POW: n->total = n->r->op == OP_CONST && is_int(n->r->value) && n->r->value >= 0 && node_total(n->l); break;
+            case OP_SIN: case OP_COS: case OP_EXP: n->total = node_total(n->l); break;
+            default: n->total = 0; break;
+        }
+    }
+    return n->total;
+}
+
+/* true if u^a * u^b = u^(a+b) for every real u: with a, b >= 0 both sides
+ * agree at u = 0, and for u < 0 each side is defined exactly when its
+ * exponents are integers */
+static int pow_merge_ok(double a, double b) {
+    return a >= 0 && b >= 0 && ((is_int(a) && is_int(b)) || !is_int(a + b));
+}
+
+static Node *mk_un(NodeArena *A, OpCode op, Node *l) {
+    if (l->op == OP_CONST) return mk_const(A, fold(op, l->value, 0));
+    return node_new(A, (Node){ .op = op, .l = l });
+}
+
+static Node *mk_bin(NodeArena *A, OpCode op, Node *l, Node *r) {
+    if (l->op == OP_CONST && r->op == OP_CONST) return mk_const(A, fold(op, l->value, r->value));
+    switch (op) {
+        case OP_ADD:
+            if (is_num(l, 0)) return r;
+            if (is_num(r, 0)) return l;
+            if (l == r) return mk_bin(A, OP_MUL, mk_const(A, 2), l);
+            break;
+        case OP_SUB:
+            if (is_num(r, 0)) return l;
+            if (l == r && node_total(l)) return mk_const(A, 0);
+            break;
+        case OP_MUL:
+            if ((is_num(l, 0) && node_total(r)) || (is_num(r, 0) && node_total(l))) return mk_const(A, 0);
+            if (is_num(l, 1)) return r;
+            if (is_num(r, 1)) return l;
+            if (r->op == OP_CONST) { Node *t = l; l = r; r = t; }   // constants to the left
+            if (l->op == OP_CONST && r->op == OP_MUL && r->l->op == OP_CONST)
+                return mk_bin(A, OP_MUL, mk_const(A, l->value * r->l->value), r->r);
+            // collect powers of a common base, undoing optimize_rpn's multiply chains
+            if (l == r) return mk_bin(A, OP_POW, l, mk_const(A, 2));
+            if (r->op == OP_POW && r->r->op == OP_CONST && r->l == l && pow_merge_ok(1, r->r->value))
+                return mk_bin(A, OP_POW, l, mk_const(A, r->r->value + 1));
+            if (l->op == OP_POW && l->r->op == OP_CONST && l->l == r && pow_merge_ok(l->r->value, 1))
+                return mk_bin(A, OP_POW, r, mk_const(A, l->r->value + 1));
+            if (l->op == OP_POW && r->op == OP_POW && l->l == r->l && l->r->op == OP_CONST && r->r->op == OP_CONST
+                && pow_merge_ok(l->r->value, r->r->value))
+                return mk_bin(A, OP_POW, l->l, mk_const(A, l->r->value + r->r->value));
+            break;
+        case OP_DIV:
+            if (is_num(r, 1)) return l;
+            break;
+        case OP_POW:
+            if (is_num(r, 0)) return mk_const(A, 1);
+            if (is_num(r, 1)) return l;
+            // (u^a)^n = u^(a*n) at u < 0 only if a is an integer or neither side is defined there
+            if (l->op == OP_POW && l->r->op == OP_CONST && r->op == OP_CONST && is_int(r->value)
+                && (is_int(l->r->value) || !is_int(l->r->value * r->value)))
+                return mk_bin(A, OP_POW, l->l, mk_const(A, l->r->value * r->value));
+            break;
+        default: break;
+    }
+    return node_new(A, (Node){ .op = op, .l = l, .r = r });
+}
+
+// d/d(var wrt) of n, memoised per node so shared subexpressions are derived once
+static Node *tree_derive_node(NodeArena *A, Node *n, uint32_t wrt);
+static Node *tree_derive(NodeArena *A, Node *n, uint32_t wrt) {
+    if (n->deriv == NULL) n->deriv = tree_derive_node(A, n, wrt);
+    return n->deriv;
+}
+
+static Node *tree_derive_node(NodeArena *A, Node *n, uint32_t wrt) {
+    Node *u = n->l, *v = n->r, *du, *dv;
+    switch (n->op) {
+        case OP_CONST: case OP_PARAM: return mk_const(A, 0);
+        case OP_VAR:   return mk_const(A, n->arg == wrt);
+        default: break;
+    }
+    du = tree_derive(A, u, wrt);
+    switch (n->op) {
+        case OP_SIN:  return mk_bin(A, OP_MUL, mk_un(A, OP_COS, u), du);
+        case OP_COS:  return mk_bin(A, OP_SUB, mk_const(A, 0), mk_bin(A, OP_MUL, mk_un(A, OP_SIN, u), du));
+        case OP_TAN:  return mk_bin(A, OP_DIV, du, mk_bin(A, OP_POW, mk_un(A, OP_COS, u), mk_const(A, 2)));
+        case OP_EXP:  return mk_bin(A, OP_MUL, n, du);
+        case OP_LOG:  return mk_bin(A, OP_DIV, du, u);
+        case OP_SQRT: return mk_bin(A, OP_DIV, du, mk_bin(A, OP_MUL, mk_const(A, 2), n));
+        default: break;
+    }
+    dv = tree_derive(A, v, wrt);
+    switch (n->op) {
+        case OP_ADD: return mk_bin(A, OP_ADD, du, dv);
+        case OP_SUB: return mk_bin(A, OP_SUB, du, dv);
+        case OP_MUL: return mk_bin(A, OP_ADD, mk_bin(A, OP_MUL, du, v), mk_bin(A, OP_MUL, u, dv));
+        case OP_DIV: return mk_bin(A, OP_DIV, mk_bin(A, OP_SUB, mk_bin(A, OP_MUL, du, v), mk_bin(A, OP_MUL, u, dv)),
+                                              mk_bin(A, OP_POW, v, mk_const(A, 2)));
+        default: break;
+    }
+    // u^v; a parameter exponent is constant too, and this form keeps u < 0 valid
+    if (v->op == OP_CONST || v->op == OP_PARAM)
+        return mk_bin(A, OP_MUL, mk_bin(A, OP_MUL, v, mk_bin(A, OP_POW, u, mk_bin(A, OP_SUB, v, mk_const(A, 1)))), du);
+    if (u->op == OP_CONST)
+        return mk_bin(A, OP_MUL, mk_bin(A, OP_MUL, n, mk_const(A, log(u->value))), dv);
+    return mk_bin(A, OP_MUL, n, mk_bin(A, OP_ADD, mk_bin(A, OP_MUL, dv, mk_un(A, OP_LOG, u)),
+                                                  mk_bin(A, OP_DIV, mk_bin(A, OP_MUL, v, du), u)));
+}
+
+// plain postorder, shared nodes repeated; CSE happens after optimize_rpn()
+static void tree_emit(Expr *out, const Node *n) {
+    if (n->op == OP_CONST) { emit(out, OP_CONST, add_const(out, n->value)); return; }
+    if (n->op == OP_VAR || n->op == OP_PARAM) { emit(out, n->op, n->arg); return; }
+    tree_emit(out, n->l);
+    if (n->r) tree_emit(out, n->r);
+    emit(out, n->op, 0);
+}
+
+// makes e read src's parameters, so setting them on either affects both
+static void expr_share_params(Expr *e, const Expr *src) {
+    e->params = src->params;
+    if (e->params) atomic_fetch_add(&e->params->refs, 1);
+}
+
+static Expr *tree_to_expr(const Node *root, const Expr *src) {
+    Expr *raw = calloc(1, sizeof *raw);
+    tree_emit(raw, root);
+    raw->depth = rpn_depth(raw);
+    Expr *opt = optimize_rpn(raw);
+    Expr *e = cse_rpn(opt);
+    expr_set_vars(e, (const char *const *)src->vars, src->nvars);
+    expr_share_params(e, src);
+    expr_free(raw);
+    expr_free(opt);
+    return e;
+}
+
+/* partial derivative with respect to variable wrt; it has the same variables
+ * as e and reads e's parameters, which count as constants */
+const Expr *expr_derive_var(const Expr *e, int wrt) {
+    NodeArena A = {0};
+    Expr *d = tree_to_expr(tree_derive(&A, tree_from_expr(&A, e, mk_un, mk_bin), wrt), e);
+    arena_free(&A);
+    return d;
+}
+
+const Expr *expr_derive(const Expr *e) {
+    return expr_derive_var(e, 0);
+}
+
+/* --- Infix printing ---
+ * Parenthesises exactly where the parser would otherwise group differently,
+ * so the printed text parses back to an expression that evaluates the same
+ * operations in the same order. */
+static int node_prec(const Node *n) {
+    switch (n->op) {
+        case OP_ADD: case OP_SUB: return 1;
+        case OP_MUL: case OP_DIV: return 2;
+        case OP_POW:              return 3;
+        case OP_CONST:            return n->value < 0 ? 0 : 4;
+        default:                  return 4;
+    }
+}
+
+// shortest of %.15g/%.17g that reads back as the same double
+static void print_const(double v, FILE *out) {
+    char buf[32];
+    snprintf(buf, sizeof buf, "%.15g", v);
+    if (strtod(buf, NULL) != v) snprintf(buf, sizeof buf, "%.17g", v);
+    fprintf(out, "%s", buf);
+}
+
+// names of variables and parameters come from e
+static void tree_print(const Node *n, const Expr *e, FILE *out) {
+    if (n->op == OP_CONST) { print_const(n->value, out); return; }
+    if (n->op == OP_VAR)   { fprintf(out, "%s", e->vars[n->arg]); return; }
+    if (n->op == OP_PARAM) { fprintf(out, "$%s", e->params->names[n->arg]); return; }
+    if (n->r == NULL) {
+        fprintf(out, "%s(", op_name(n->op));
+        tree_print(n->l, e, out);
+        fprintf(out, ")");
+        return;
+    }
+    int p = node_prec(n);
+    int lp = node_prec(n->l) < p || (n->op == OP_POW && node_prec(n->l) == p);
+    int rp = node_prec(n->r) < p || (n->op != OP_POW && node_prec(n->r) == p);
+    if (lp) fprintf(out, "(");
+    tree_print(n->l, e, out);
+    fprintf(out, lp ? ")%s" : "%s", op_name(n->op));
+    if (rp) fprintf(out, "(");
+    tree_print(n->r, e, out);
+    fprintf(out, rp ? ")" : "");
+}
+
+void expr_print(const Expr *e, FILE *out) {
+    NodeArena A = {0};
+    tree_print(tree_from_expr(&A, e, NULL, NULL), e, out);
+    fprintf(out, "\n");
+    arena_free(&A);
+}
+
+#endif // RPN_SYMBOLIC_H
@@ -0,0 +1,211 @@
+#ifndef RPN_VMATH_H
+#define RPN_VMATH_H
+
+/* --- Vector math kernels ---
+ * sin, cos, tan, exp, log and sqrt over arrays of doubles, VMATH_LANES
+ * values at a time, written with GCC vector extensions: 2 lanes on plain
+ * SSE2, 4 with -mavx, 8 with -mavx512f. The batch evaluator uses them for
+ * its function opcodes unless EXPR_STRICT_LIBM is defined.
+ *
+ * Error bounds, against a long double reference over the ranges in
+ * bench/vmath_bench.c (make bench-vmath checks them):
+ *   sin, cos, exp, log    1 ulp
+ *   tan                   2.5 ulp
+ *   sqrt                  correctly rounded, same bits as libm
+ * libm itself is within 1 ulp for these, so results can differ from
+ * expr_eval() in the last bit or two.
+ *
+ * The polynomials are fdlibm's. sin, cos and tan reduce by multiples of
+ * pi/2 with a three-part Cody-Waite constant, exact enough for |x| <= 2^20.
+ * Lanes outside the range a kernel handles (huge or non-finite arguments,
+ * exp overflow and underflow, log of zero, negatives and subnormals) are
+ * recomputed with libm, so special values come out exactly as libm gives
+ * them. */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+#define VMATH_LANES 8
+#elif defined(__AVX__)
+#define VMATH_LANES 4
+#else
+#define VMATH_LANES 2
+#endif
+
+typedef double   vmath_vd __attribute__((vector_size(VMATH_LANES * sizeof(double))));
+typedef int64_t  vmath_vl __attribute__((vector_size(VMATH_LANES * sizeof(double))));
+typedef uint64_t vmath_vu __attribute__((vector_size(VMATH_LANES * sizeof(double))));
+
+// 1.5 * 2^52: adding it rounds to an integer held in the low mantissa bits
+#define VMATH_SHIFT      0x1.8p52
+#define VMATH_SHIFT_BITS 0x4338000000000000
+
+static inline vmath_vd vmath_sel(vmath_vl m, vmath_vd a, vmath_vd b) {
+    return (vmath_vd)(((vmath_vl)a & m) | ((vmath_vl)b & ~m));
+}
+
+static inline vmath_vd vmath_abs(vmath_vd x) {
+    return (vmath_vd)((vmath_vl)x & INT64_MAX);
+}
+
+static inline vmath_vd vmath_flip(vmath_vl m, vmath_vd x) {
+    return (vmath_vd)((vmath_vl)x ^ (m & INT64_MIN));
+}
+
+/* Integer lanes below 2^51 to double, and a mask of the lanes with bit b
+ * set, both by way of VMATH_SHIFT: SSE2 has no 64-bit integer compare or
+ * conversion, and the vector extensions would fall back to scalar code. */
+static inline vmath_vd vmath_to_double(vmath_vl k) {
+    return (vmath_vd)(k + VMATH_SHIFT_BITS) - VMATH_SHIFT;
+}
+
+static inline vmath_vl vmath_bit(vmath_vl v, int64_t b) {
+    return (vmath_vd)((v & b) | VMATH_SHIFT_BITS) != VMATH_SHIFT;
+}
+
+/* --- exp ---
+ * x = n ln2 + r with |r| <= ln2/2, then fdlibm's rational form of e^r and
+ * a scale by 2^n built straight into the exponent bits. */
+static inline vmath_vd vmath_exp4(vmath_vd x, vmath_vl *bad) {
+    const double ln2_hi = 6.93147180369123816490e-01, ln2_lo = 1.90821492927058770002e-10;
+    const double P1 = 1.66666666666666019037e-01, P2 = -2.77777777770155933842e-03,
+                 P3 = 6.61375632143793436117e-05, P4 = -1.65339022054652515390e-06,
+                 P5 = 4.13813679705723846039e-08;
+    *bad = ~(vmath_abs(x) <= 708.0);
+    vmath_vd t = x * M_LOG2E + VMATH_SHIFT, k = t - VMATH_SHIFT;
+    vmath_vl n = (vmath_vl)t - VMATH_SHIFT_BITS;
+    vmath_vd hi = x - k * ln2_hi, lo = k * ln2_lo, r = hi - lo, z = r * r;
+    vmath_vd c = r - z * (P1 + z * (P2 + z * (P3 + z * (P4 + z * P5))));
+    vmath_vd y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+    return y * (vmath_vd)((vmath_vu)(n + 1023) << 52);
+}
+
+/* --- log ---
+ * x = 2^k m with m in [sqrt(2)/2, sqrt(2)), f = m - 1, and log(1 + f)
+ * from fdlibm's series in s = f / (2 + f). Positive normal x only. */
+static inline vmath_vd vmath_log4(vmath_vd x, vmath_vl *bad) {
+    const double ln2_hi = 6.93147180369123816490e-01, ln2_lo = 1.90821492927058770002e-10;
+    const double Lg1 = 6.666666666666735130e-01, Lg2 = 3.999999999940941908e-01,
+                 Lg3 = 2.857142874366239149e-01, Lg4 = 2.222219843214978396e-01,
+                 Lg5 = 1.818357216161805012e-01, Lg6 = 1.531383769920937332e-01,
+                 Lg7 = 1.479819860511658591e-01;
+    *bad = ~((x >= 0x1p-1022) & (x <= 0x1.fffffffffffffp1023));
+    vmath_vu bits = (vmath_vu)x;
+    vmath_vl k = (vmath_vl)(bits >> 52) - 1023;
+    vmath_vd m = (vmath_vd)((bits & 0x000fffffffffffff) | 0x3ff0000000000000);
+    vmath_vl big = m > M_SQRT2;
+    m = vmath_sel(big, m * 0.5, m);
+    vmath_vd dk = vmath_to_double(k - big);
+    vmath_vd f = m - 1.0, s = f / (2.0 + f), z = s * s, w = z * z;
+    vmath_vd t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    vmath_vd t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    vmath_vd hfsq = 0.5 * f * f;
+    return dk * ln2_hi - ((hfsq - (s * (hfsq + t1 + t2) + dk * ln2_lo)) - f);
+}
+
+/* --- sin, cos, tan ---
+ * x = n pi/2 + y + ylo with |y| <= pi/4. pi/2 is split in three so that n
+ * times the first two parts is exact for |n| < 2^20; the one subtraction
+ * that is not exact is done as a two-sum, and ylo keeps what rounding y
+ * drops. Lanes that land within 1e-7 of a multiple of pi/2 go to libm:
+ * there the reduction error, small as it is, would show relative to y.
+ * q gets n mod 4. */
+static inline vmath_vd vmath_reduce(vmath_vd x, vmath_vd *ylo, vmath_vl *q, vmath_vl *bad) {
+    const double pio2_1 = 1.57079632673412561417e+00, pio2_2 = 6.07710050630396597660e-11,
+                 pio2_3 = 2.02226624871116645580e-21;
+    vmath_vd t = x * M_2_PI + VMATH_SHIFT, n = t - VMATH_SHIFT;
+    *q = (vmath_vl)t & 3;
+    vmath_vd a = x - n * pio2_1, b = -(n * pio2_2);
+    vmath_vd r = a + b, bb = r - a, e = (a - (r - bb)) + (b - bb) - n * pio2_3;
+    vmath_vd y = r + e;
+    vmath_vl zero = n == 0.0;
+    *bad = ~(vmath_abs(x) <= 0x1p20) | (~zero & (vmath_abs(y) < 1e-7));
+    *ylo = vmath_sel(zero, (vmath_vd){0}, (r - y) + e);
+    return vmath_sel(zero, x, y);
+}
+
+// sin(y + ylo) and cos(y + ylo) for |y| <= pi/4, fdlibm's __kernel_sin/cos
+static inline vmath_vd vmath_sin_poly(vmath_vd y, vmath_vd ylo) {
+    const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                 S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                 S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+    vmath_vd z = y * y, v = z * y;
+    vmath_vd r = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+    return y - ((z * (0.5 * ylo - v * r) - ylo) - v * S1);
+}
+
+static inline vmath_vd vmath_cos_poly(vmath_vd y, vmath_vd ylo) {
+    const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                 C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                 C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+    vmath_vd z = y * y, hz = 0.5 * z, w = 1.0 - hz;
+    vmath_vd r = z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    return w + (((1.0 - w) - hz) + (z * r - y * ylo));
+}
+
+// the polynomials lose the sign of zero; sin and tan give it back
+static inline vmath_vd vmath_sin4(vmath_vd x, vmath_vl *bad) {
+    vmath_vl q;
+    vmath_vd ylo, y = vmath_reduce(x, &ylo, &q, bad);
+    vmath_vd r = vmath_sel(vmath_bit(q, 1), vmath_cos_poly(y, ylo), vmath_sin_poly(y, ylo));
+    return vmath_sel(x == 0.0, x, vmath_flip(vmath_bit(q, 2), r));
+}
+
+static inline vmath_vd vmath_cos4(vmath_vd x, vmath_vl *bad) {
+    vmath_vl q;
+    vmath_vd ylo, y = vmath_reduce(x, &ylo, &q, bad);
+    vmath_vd r = vmath_sel(vmath_bit(q, 1), vmath_sin_poly(y, ylo), vmath_cos_poly(y, ylo));
+    return vmath_flip(vmath_bit(q + 1, 2), r);
+}
+
+static inline vmath_vd vmath_tan4(vmath_vd x, vmath_vl *bad) {
+    vmath_vl q;
+    vmath_vd ylo, y = vmath_reduce(x, &ylo, &q, bad);
+    vmath_vd s = vmath_sin_poly(y, ylo), c = vmath_cos_poly(y, ylo);
+    return vmath_sel(x == 0.0, x, vmath_sel(vmath_bit(q, 1), -c / s, s / c));
+}
+
+/* --- sqrt ---
+ * The hardware instruction is correctly rounded, so this is libm's answer
+ * without the call and the errno check around it. */
+static inline vmath_vd vmath_sqrt4(vmath_vd x, vmath_vl *bad) {
+    *bad = (vmath_vl){0};
+#ifdef __SSE2__
+    __m128d h[VMATH_LANES / 2];
+    memcpy(h, &x, sizeof x);
+    for (int i = 0; i < VMATH_LANES / 2; i++) h[i] = _mm_sqrt_pd(h[i]);
+    memcpy(&x, h, sizeof x);
+#else
+    for (int i = 0; i < VMATH_LANES; i++) x[i] = sqrt(x[i]);
+#endif
+    return x;
+}
+
+/* --- Array entry points ---
+ * y[i] = f(x[i]) for i < n; y may be x. A short last block is padded with
+ * ones, which every kernel accepts. */
+#define VMATH_ARRAY(name)                                                           \
+    void vmath_##name(double *y, const double *x, size_t n) {                       \
+        for (size_t i = 0; i < n; i += VMATH_LANES) {                               \
+            size_t m = n - i < VMATH_LANES ? n - i : VMATH_LANES;                   \
+            vmath_vd v = (vmath_vd){0} + 1.0, r;                                    \
+            vmath_vl bad;                                                           \
+            if (m == VMATH_LANES) memcpy(&v, x + i, sizeof v);                      \
+            else memcpy(&v, x + i, m * sizeof *x);                                  \
+            r = vmath_##name##4(v, &bad);                                           \
+            for (size_t j = 0; j < m; j++)                                          \
+                if (bad[j]) r[j] = name(v[j]);                                      \
+            if (m == VMATH_LANES) memcpy(y + i, &r, sizeof r);                      \
+            else memcpy(y + i, &r, m * sizeof *y);                                  \
+        }                                                                           \
+    }
+VMATH_ARRAY(sin) VMATH_ARRAY(cos) VMATH_ARRAY(tan)
+VMATH_ARRAY(exp) VMATH_ARRAY(log) VMATH_ARRAY(sqrt)
+#undef VMATH_ARRAY
+
+#endif // RPN_VMATH_H
@@ -0,0 +1,91 @@
+/* expr_jit() must give the same bits as expr_eval() for every input.
+ *
+ * The programs together contain every opcode, which is checked before any
+ * value is compared, including OP_DUP, OP_LOAD/OP_STORE and OP_PARAM, and
+ * one program whose frame spans several pages. Each is run over a sweep of
+ * x plus zeros, infinities, NaN, subnormals and values near overflow. The
+ * parameters are changed after compiling, to check the code reads them
+ * live.
+ *
+ * Exits non-zero on the first mismatch. Run by `make test`.
+ *
+ * Usage: ./jit_test
+ */
+#include "../parser/parser.h"
+#include "../parser/jit.h"
+
+static const char *exprs[] = {
+    "x + 2 - 3*x / 5",
+    "x^2.5 + 2^x + x^-3",
+    "sin(x) + cos(x) - tan(x)",
+    "exp(x/7) * log(x) + sqrt(x)",
+    "x^7 - x^2",                                  // multiply chains: OP_DUP
+    "sin(x+1)*cos(x+1) + (x+1)/(x-2) - (x-2)^3",  // shared subexpressions: OP_LOAD/OP_STORE
+    "$a*sin(x) - $b*x + $a",                      // OP_PARAM
+    "3.5 - 1e300*x*x + 1e-310",
+};
+
+// x with no arithmetic in between, so both backends see the same input bits
+static const double specials[] = {
+    0.0, -0.0, 1.0, -1.0, 0.5, 2.0, 3.0, 1e-310, -1e-310, 1e300, -1e300,
+    INFINITY, -INFINITY, NAN, 0x1.fffffffffffffp+1023, 1.5707963267948966,
+};
+
+static int check(const char *text, const Expr *e, double (*f)(double)) {
+    double xs[sizeof specials / sizeof *specials + 2000];
+    size_t n = 0;
+    for (size_t i = 0; i < sizeof specials / sizeof *specials; i++) xs[n++] = specials[i];
+    for (int i = 0; i < 2000; i++) xs[n++] = -50 + i * 0.0503;
+    for (size_t i = 0; i < n; i++) {
+        double a = expr_eval(e, xs[i]), b = f(xs[i]);
+        if (memcmp(&a, &b, sizeof a)) {
+            printf("FAIL %s at x = %a: interpreter %a, jit %a\n", text, xs[i], a, b);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int run(const char *text, int *seen) {
+    const Expr *e = parse_function(text);
+    for (int i = 0; i < e->len; i++) seen[e->code[i].op] = 1;
+    double (*f)(double) = expr_jit(e);
+    if (f == NULL) { printf("FAIL %s: expr_jit() returned NULL\n", text); expr_free(e); return 1; }
+    int bad = check(text, e, f);
+    for (int i = 0; !bad && e->params && i < e->params->n; i++) {
+        expr_set_param(e, i, 1.25 + i);
+        bad = check(text, e, f);
+    }
+    printf("%-48.48s depth %4d, slots %4d: %s\n", text, e->depth, e->nslots, bad ? "FAIL" : "ok");
+    expr_jit_free(f);
+    expr_free(e);
+    return bad;
+}
+
+int main(void){
+    if (!EXPR_HAVE_JIT) { printf("JIT backend not available on this platform, nothing to test\n"); return 0; }
+    int seen[OP_SQRT + 1] = {0};
+    for (size_t k = 0; k < sizeof exprs / sizeof *exprs; k++)
+        if (run(exprs[k], seen)) return 1;
+
+    // nested so that every term is still on the stack when the innermost is
+    // computed, and each term shares x+k: a thousand stack and a thousand
+    // CSE slots, a frame of several pages
+    enum { NTERMS = 1000 };
+    char *big = malloc(NTERMS * 64), *p = big;
+    for (int k = 1; k <= NTERMS; k++) p += sprintf(p, "sin(x+%d)*cos(x+%d) + (", k, k);
+    p += sprintf(p, "x");
+    for (int k = 1; k <= NTERMS; k++) *p++ = ')';
+    *p = 0;
+    const Expr *e = parse_function(big);
+    if (8 * (e->depth + e->nslots) < 3 * 4096) { printf("FAIL large frame: only %d + %d slots\n", e->depth, e->nslots); return 1; }
+    expr_free(e);
+    int bad = run(big, seen);
+    free(big);
+    if (bad) return 1;
+
+    for (int op = 0; op <= OP_SQRT; op++)
+        if (!seen[op]) { printf("FAIL no program exercises %s\n", op_name(op)); return 1; }
+    printf("all %d opcodes covered, jit and interpreter agree\n", OP_SQRT + 1);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef TYPED_TEMPLATE_H
+#define TYPED_TEMPLATE_H
+
+/* --- Precision templates ---
+ * Each *_typed.h file holds one body for every floating type. Its parent
+ * header includes it once per precision, with TYPED_T set to the value type
+ * and TYPED_SFX to the libm suffix that goes with it (empty for double, f
+ * for float, l for long double):
+ *
+ *     #define TYPED_T float
+ *     #define TYPED_SFX f
+ *     #include "bisection_typed.h"
+ *
+ * TYPED_NAME(name) appends the suffix, so every function a template defines
+ * comes out as name, namef and namel, and TYPED_NAME(fabs) calls the libm
+ * function of the matching precision. A template starts by including this
+ * file and ends by undefining TYPED_T and TYPED_SFX, ready for the next
+ * precision; it has no include guard on purpose. */
+
+#define TYPED_CAT_(a, b) a##b
+#define TYPED_CAT(a, b)  TYPED_CAT_(a, b)
+#define TYPED_NAME(name) TYPED_CAT(name, TYPED_SFX)
+
+#endif // TYPED_TEMPLATE_H